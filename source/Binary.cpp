@@ -0,0 +1,159 @@
+/* Binary.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Binary.h"
+
+using namespace std;
+
+namespace {
+	// Write a value to a binary stream, or read one back.
+	template <class T>
+	void WriteValue(ostream &out, const T &value);
+	template <class T>
+	bool ReadValue(istream &in, T &value);
+}
+
+
+
+void Binary::Write(ostream &out, uint8_t value)
+{
+	WriteValue(out, value);
+}
+
+
+
+void Binary::Write(ostream &out, int32_t value)
+{
+	WriteValue(out, value);
+}
+
+
+
+void Binary::Write(ostream &out, uint32_t value)
+{
+	WriteValue(out, value);
+}
+
+
+
+void Binary::Write(ostream &out, uint64_t value)
+{
+	WriteValue(out, value);
+}
+
+
+
+void Binary::Write(ostream &out, double value)
+{
+	WriteValue(out, value);
+}
+
+
+
+// Write a string to a binary stream, preceded by its length.
+void Binary::Write(ostream &out, const string &text)
+{
+	Write(out, static_cast<uint32_t>(text.length()));
+	out.write(text.data(), text.length());
+}
+
+
+
+bool Binary::Read(istream &in, uint8_t &value)
+{
+	return ReadValue(in, value);
+}
+
+
+
+bool Binary::Read(istream &in, int32_t &value)
+{
+	return ReadValue(in, value);
+}
+
+
+
+bool Binary::Read(istream &in, uint32_t &value)
+{
+	return ReadValue(in, value);
+}
+
+
+
+bool Binary::Read(istream &in, uint64_t &value)
+{
+	return ReadValue(in, value);
+}
+
+
+
+bool Binary::Read(istream &in, double &value)
+{
+	return ReadValue(in, value);
+}
+
+
+
+// Read a string that was written along with its length. The length is checked
+// before the string is allocated, in case the file is damaged.
+bool Binary::Read(istream &in, string &text)
+{
+	uint32_t length = 0;
+	if(!Read(in, length))
+		return false;
+	if(!HasBytes(in, length))
+	{
+		in.setstate(ios::failbit);
+		return false;
+	}
+	text.resize(length);
+	return length == 0 || static_cast<bool>(in.read(&text[0], length));
+}
+
+
+
+// Check if there are at least the given number of bytes left to read. Most
+// of the time they are already in the stream's buffer; if not, seek to the
+// end to find out how long the stream is.
+bool Binary::HasBytes(istream &in, uint64_t count)
+{
+	streamsize buffered = in.rdbuf()->in_avail();
+	if(buffered >= 0 && static_cast<uint64_t>(buffered) >= count)
+		return true;
+	
+	streampos here = in.tellg();
+	if(here < 0 || !in.seekg(0, ios::end))
+		return false;
+	streampos end = in.tellg();
+	in.seekg(here);
+	return end >= here && static_cast<uint64_t>(end - here) >= count;
+}
+
+
+
+namespace {
+	// Write a value to a binary stream, as it is stored in memory.
+	template <class T>
+	void WriteValue(ostream &out, const T &value)
+	{
+		out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+	
+	
+	
+	// Read a value from a binary stream.
+	template <class T>
+	bool ReadValue(istream &in, T &value)
+	{
+		return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+	}
+}
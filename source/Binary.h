@@ -0,0 +1,54 @@
+/* Binary.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef BINARY_H_
+#define BINARY_H_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+
+
+// Functions for writing values to a binary file and reading them back, as they
+// are stored in memory. Strings are stored as a 32-bit length followed by the
+// text. Each Read() returns false if the value can't be read, which includes a
+// string whose length is more than what is left in the file, so a damaged file
+// never causes a huge allocation.
+class Binary {
+public:
+	static void Write(ostream &out, uint8_t value);
+	static void Write(ostream &out, int32_t value);
+	static void Write(ostream &out, uint32_t value);
+	static void Write(ostream &out, uint64_t value);
+	static void Write(ostream &out, double value);
+	static void Write(ostream &out, const string &text);
+	
+	static bool Read(istream &in, uint8_t &value);
+	static bool Read(istream &in, int32_t &value);
+	static bool Read(istream &in, uint32_t &value);
+	static bool Read(istream &in, uint64_t &value);
+	static bool Read(istream &in, double &value);
+	static bool Read(istream &in, string &text);
+	
+	// Check if there are at least the given number of bytes left to read. A
+	// count of items that was read from a file should be checked with this
+	// before making room for that many items.
+	static bool HasBytes(istream &in, uint64_t count);
+};
+
+
+
+#endif
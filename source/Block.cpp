@@ -12,31 +12,47 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Block.h"
 
+#include "Chord.h"
+#include "StringTable.h"
+#include "Unicode.h"
+
 using namespace std;
 
 
 
-// Add text of the given type.
-void Block::Add(const string &line, TextType type)
+// Add the given tokens of text of the given type.
+void Block::Add(const vector<string> &tokens, TextType type)
 {
-	// If this is the first line in this block of the given type and it starts
-	// with whitespace, this line of the block should be indented.
-	bool indent = (lines[type].empty() && !line.empty() && line.front() <= ' ' && line.front() > 0);
-	if(indent)
-		isIndented[type] = true;
-	
-	// Add the given line, not counting the indent character if any.
-	lines[type].append(line, indent, line.length() - indent);
-	// Always add a space after chords, so they don't run into each other.
-	// The actual text has spaces already.
-	if(type == TextType::CHORD)
-		lines[type] += ' ';
+	// Build the whole line before adding it to the StringTable, so that the
+	// table does not fill up with every partial line.
+	string text = StringTable::Get(lines[type]);
+	for(const string &line : tokens)
+	{
+		// If this is the first text in this line of the block and it starts
+		// with whitespace (which may be a Unicode space, the same as for the
+		// indentation of the whole line), this line of the block should be
+		// indented.
+		size_t indent = (text.empty() ? Unicode::SpaceLength(line, 0) : 0);
+		if(indent)
+			isIndented[type] = true;
+		
+		// Add the given text, not counting the indent character if any.
+		text.append(line, indent, line.length() - indent);
+		// Always add a space after chords, so they don't run into each other.
+		// The actual text has spaces already.
+		if(type == TextType::CHORD)
+		{
+			text += ' ';
+			chords.push_back(Chord::Intern(line.substr(indent)));
+		}
+	}
+	lines[type] = StringTable::Intern(text);
 }
 
 // Check what lines of the block are occupied.
 bool Block::Has(TextType type) const
 {
-	return static_cast<size_t>(type) < 3 && !lines[type].empty();
+	return static_cast<size_t>(type) < 3 && lines[type] != StringTable::EMPTY;
 }
 
 
@@ -44,9 +60,16 @@ bool Block::Has(TextType type) const
 // Get one of the lines of the block.
 const string &Block::Get(TextType type) const
 {
-	static const string EMPTY;
+	return StringTable::Get(Id(type));
+}
+
+
+
+// Get the StringTable ID of one of the lines of the block.
+uint32_t Block::Id(TextType type) const
+{
 	if(static_cast<size_t>(type) >= 3)
-		return EMPTY;
+		return StringTable::EMPTY;
 	
 	return lines[type];
 }
@@ -58,3 +81,34 @@ bool Block::IsIndented(TextType type) const
 {
 	return Has(type) && isIndented[type];
 }
+
+
+
+// Check if two blocks have the same text and indentation.
+bool Block::operator==(const Block &other) const
+{
+	for(size_t i = 0; i < 3; ++i)
+		if(lines[i] != other.lines[i] || isIndented[i] != other.isIndented[i])
+			return false;
+	return true;
+}
+
+
+
+// Transpose the chords in this block by the given number of semitones from
+// the key they were written in.
+bool Block::Transpose(int semitones)
+{
+	string text;
+	for(uint32_t id : chords)
+	{
+		text += Chord::Text(Chord::Transpose(id, semitones));
+		text += ' ';
+	}
+	uint32_t id = StringTable::Intern(text);
+	if(id == lines[TextType::CHORD])
+		return false;
+	
+	lines[TextType::CHORD] = id;
+	return true;
+}
@@ -15,7 +15,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "TextType.h"
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -25,23 +27,38 @@ using namespace std;
 // is left-aligned, and the block's width is the width of the longest line.
 class Block {
 public:
-	// Add text of the given type.
-	void Add(const string &line, TextType type);
+	// Add the given tokens of text of the given type, one after another. Each
+	// line of the block is only added to the StringTable once, so this should
+	// be given all the tokens for that line at once.
+	void Add(const vector<string> &tokens, TextType type);
 	
 	// Check what lines of the block are occupied.
 	bool Has(TextType type) const;
 	
-	// Get one of the lines of the block.
+	// Get one of the lines of the block, or its ID in the StringTable.
 	const string &Get(TextType type) const;
+	uint32_t Id(TextType type) const;
 	
 	// Check if each line of the block in indented. Return true if the given
 	// type of text does not exist in this block.
 	bool IsIndented(TextType type) const;
 	
+	// Transpose the chords in this block by the given number of semitones
+	// from the key they were written in. This returns false if the text of
+	// the chords did not change.
+	bool Transpose(int semitones);
+	
+	// Check if two blocks have the same text and indentation.
+	bool operator==(const Block &other) const;
+	
 	
 private:
-	string lines[3];
+	// The text of each line is stored in the StringTable, because the same
+	// chords and lyrics tend to be repeated many times.
+	uint32_t lines[3] = {0, 0, 0};
 	bool isIndented[3] = {false, false, false};
+	// The IDs of the chords in this block, as originally written.
+	vector<uint32_t> chords;
 };
 
 
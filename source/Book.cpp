@@ -0,0 +1,810 @@
+/* Book.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Book.h"
+
+#include "Contents.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+	// Stop searching for the best text size once the range is this small.
+	const double FIT_PRECISION = .1;
+	
+	// When packing songs, a stanza is the smallest unit that may be moved to
+	// the next page. The first stanza of each song also includes the title.
+	// Stanzas too tall to fit on one page are split into single lines.
+	class Stanza {
+	public:
+		const Song *song;
+		// The range of lines in this stanza. Any empty lines after the stanza
+		// are included in this range, but not counted in its height.
+		size_t begin;
+		size_t end;
+		// The height of the stanza itself, and of the empty lines after it.
+		double height;
+		double gap;
+	};
+	
+	// A range of lines of a song that is shown on one slide. Two stanzas are
+	// the same if all their lines are, even if they are in different songs.
+	class StanzaKey {
+	public:
+		const Line *begin;
+		const Line *end;
+	};
+	class StanzaHash {
+	public:
+		size_t operator()(const StanzaKey &key) const;
+	};
+	class StanzaEqual {
+	public:
+		bool operator()(const StanzaKey &a, const StanzaKey &b) const { return a.end - a.begin == b.end - b.begin && equal(a.begin, a.end, b.begin); }
+	};
+	
+	// Check if the given song fits on a single page at its current text size.
+	// The pages vector is passed in so its storage can be reused.
+	bool FitsOnOnePage(const Song &song, vector<Page> &pages);
+	// Lay out the given lines of a song on a single slide, without wrapping
+	// any of them, at the current text size. Returns false if they don't fit.
+	bool FitsOnSlide(const Song &song, size_t begin, size_t end, bool hasTitle, Page &slide);
+	// Lay out the given lines of a song on their own slide, at the largest text
+	// size between the given limits at which they fit, or on several slides
+	// at the minimum size if they do not fit at all.
+	void FitSlide(const Song &song, size_t begin, size_t end, bool hasTitle, double minSize, double maxSize, vector<Page> &slides);
+	
+	// Lay out the title block of the given song on the given page.
+	void AddTitle(const Song &song, Page &page);
+	// Lay out a line of a song, starting new pages as needed.
+	void AddLine(const Line &line, vector<Page> &pages);
+	
+	// Split the given song into stanzas, measuring the height of each one.
+	void SplitStanzas(const Song &song, vector<Stanza> &stanzas);
+	// Measure the gap that separates the given song from the song before it,
+	// if they are on the same page.
+	double SongGap(const Song &song);
+	// Choose the order of the songs so that short songs fill space left over
+	// at the ends of the pages of other songs.
+	vector<const Song *> Reorder(const vector<const Song *> &songs);
+	// Choose which stanzas start a new page, so as to use as few pages as
+	// possible and, among layouts with that many pages, to have as few songs
+	// as possible that are split across pages.
+	vector<bool> ChooseBreaks(const vector<Stanza> &stanzas);
+	// Choose which pages start a new volume, given the page each song starts
+	// on, so that no volume has more than the given number of pages.
+	vector<size_t> ChooseVolumes(const vector<size_t> &firstPage, size_t pages, size_t perVolume);
+}
+
+
+
+// Add all the songs in the given file to the end of the book.
+void Book::Load(const string &path)
+{
+	ifstream in(path);
+	Load(in, Song::IsChordPro(path));
+}
+
+
+
+// Add all the songs in the given stream to the end of the book.
+void Book::Load(istream &in, bool isChordPro)
+{
+	while(in)
+	{
+		emplace_back();
+		back().Load(in, isChordPro);
+		// Make sure a song was actually loaded.
+		if(back().empty() || back().Title().empty())
+			pop_back();
+	}
+}
+
+
+
+// Lay out the songs on pages, including possibly pages at the start or end
+// for the table of contents.
+vector<Page> Book::Layout(const string &indexLocation, const string &layout, const string &packing, const string &volumes, const string &indexSort, SearchIndex *search) const
+{
+	// Check where the index is supposed to be.
+	bool hasIndex = (indexLocation != "none");
+	
+	vector<Page> pages;
+	
+	// Keep track of the order the songs were laid out in and which page each
+	// one starts on, so that the index can refer to them.
+	vector<const Song *> order;
+	vector<size_t> firstPage;
+	for(const Song &song : *this)
+		order.push_back(&song);
+	
+	// Find where each section begins and ends. Songs are never moved from one
+	// section to another, and each section starts on a new page.
+	vector<size_t> bounds(1, 0);
+	for(const pair<size_t, string> &section : sections)
+		if(section.first > bounds.back() && section.first < size())
+			bounds.push_back(section.first);
+	bounds.push_back(size());
+	
+	if(packing == "pack" || packing == "reorder")
+	{
+		// Divide all the songs into stanzas, then figure out where each page
+		// break should go. This is done separately for each section.
+		vector<Stanza> stanzas;
+		vector<bool> breaks;
+		for(size_t s = 0; s + 1 < bounds.size(); ++s)
+		{
+			auto begin = order.begin() + bounds[s];
+			auto end = order.begin() + bounds[s + 1];
+			if(packing == "reorder")
+			{
+				vector<const Song *> section = Reorder(vector<const Song *>(begin, end));
+				copy(section.begin(), section.end(), begin);
+			}
+			
+			size_t first = stanzas.size();
+			for(auto it = begin; it != end; ++it)
+				SplitStanzas(**it, stanzas);
+			vector<bool> sectionBreaks = ChooseBreaks(vector<Stanza>(stanzas.begin() + first, stanzas.end()));
+			breaks.insert(breaks.end(), sectionBreaks.begin(), sectionBreaks.end());
+		}
+		
+		for(size_t i = 0; i < stanzas.size(); ++i)
+		{
+			const Stanza &stanza = stanzas[i];
+			Page::SetTextSize(stanza.song->TextSize());
+			if(breaks[i])
+				pages.emplace_back(pages.size() + 1);
+			// If this is the start of a song, add the title, separating it
+			// from the previous song if that song is on this same page.
+			if(!stanza.begin)
+			{
+				if(!breaks[i])
+					pages.back().EndLine(Line());
+				firstPage.push_back(pages.size() - 1);
+				AddTitle(*stanza.song, pages.back());
+				if(search)
+					search->Add(*stanza.song, pages.size() - 1);
+			}
+			for(size_t j = stanza.begin; j < stanza.end; ++j)
+			{
+				AddLine((*stanza.song)[j], pages);
+				if(search)
+					search->Add((*stanza.song)[j], pages.size() - 1);
+			}
+		}
+	}
+	else
+	{
+		for(const Song &song : *this)
+		{
+			firstPage.push_back(pages.size());
+			Layout(song, pages, search);
+		}
+	}
+	// Songs may have changed the text size, so restore the configured size.
+	Page::SetTextSize(0.);
+	
+	// Figure out where each volume starts, and label every page with its
+	// volume. If there is only one volume, the pages are left unlabeled.
+	vector<size_t> volumeStart;
+	if(volumes == "sections")
+	{
+		for(size_t s = 1; s + 1 < bounds.size(); ++s)
+			volumeStart.push_back(firstPage[bounds[s]]);
+	}
+	else if(atoi(volumes.c_str()) > 0)
+		volumeStart = ChooseVolumes(firstPage, pages.size(), atoi(volumes.c_str()));
+	for(size_t i = 0, volume = 1; !volumeStart.empty() && i < pages.size(); ++i)
+	{
+		if(volume <= volumeStart.size() && i == volumeStart[volume - 1])
+			++volume;
+		pages[i].SetVolume(volume);
+	}
+	
+	// Mark where each section starts, for the PDF outline.
+	for(const pair<size_t, string> &section : sections)
+		if(section.first < order.size() && !section.second.empty())
+			pages[firstPage[section.first]].AddBookmark(section.second, 0);
+	
+	// If we're building an index, add an entry for each song and for each
+	// section heading. The index is laid out in a separate set of pages, which
+	// will be inserted in the proper place. Those pages are not numbered, so
+	// the song page numbers are already final, no matter how long it is.
+	Contents indexer(indexSort);
+	auto section = sections.begin();
+	for(size_t i = 0; hasIndex && i < order.size(); ++i)
+	{
+		for( ; section != sections.end() && section->first <= i; ++section)
+			indexer.AddSection(section->second, pages[firstPage[i]]);
+		indexer.Add(*order[i], pages[firstPage[i]]);
+	}
+	vector<Page> index;
+	if(hasIndex)
+		index = indexer.Layout();
+	// The index goes at the front of the first volume or the end of the last.
+	for(Page &page : index)
+		page.SetVolume(volumeStart.empty() ? 0 : indexLocation == "front" ? 1 : volumeStart.size() + 1);
+	
+	Assemble(pages, index, indexLocation, layout, search);
+	return pages;
+}
+
+
+
+// Lay out the songs as slides for a projector, with each stanza on its own
+// slide at the largest text size that fits.
+vector<Page> Book::Slides(double minSize, double maxSize, SearchIndex *search) const
+{
+	vector<Page> slides;
+	// Remember the slides for each stanza, so a chorus that is repeated (in
+	// this song or any other) does not need to be fitted again. The first
+	// stanza of each song includes the title, so it is never the same.
+	unordered_map<StanzaKey, vector<Page>, StanzaHash, StanzaEqual> fitted;
+	for(const Song &song : *this)
+	{
+		if(search)
+			search->Add(song, slides.size());
+		
+		size_t begin = 0;
+		while(begin < song.size() && song[begin].empty())
+			++begin;
+		bool hasTitle = true;
+		do
+		{
+			// Find the end of this stanza, and the start of the next one.
+			size_t end = begin;
+			while(end < song.size() && !song[end].empty())
+				++end;
+			size_t next = end;
+			while(next < song.size() && song[next].empty())
+				++next;
+			
+			if(search)
+				for(size_t i = begin; i < end; ++i)
+					search->Add(song[i], slides.size());
+			
+			StanzaKey key{song.data() + begin, song.data() + end};
+			auto it = (hasTitle ? fitted.end() : fitted.find(key));
+			if(it != fitted.end())
+				slides.insert(slides.end(), it->second.begin(), it->second.end());
+			else
+			{
+				size_t first = slides.size();
+				FitSlide(song, begin, end, hasTitle, minSize, maxSize, slides);
+				if(!hasTitle)
+					fitted.emplace(key, vector<Page>(slides.begin() + first, slides.end()));
+			}
+			hasTitle = false;
+			begin = next;
+		} while(begin < song.size());
+	}
+	// The slide numbers are never shown, but they keep the names of the
+	// bookmarks on different slides apart, if a song is used more than once.
+	for(size_t i = 0; i < slides.size(); ++i)
+		slides[i].SetNumber(i + 1);
+	Page::SetTextSize(0.);
+	return slides;
+}
+
+
+
+// Lay out a single song, starting on a new page at the end of the given list
+// of pages. This is all that needs to be redone if one song changes.
+void Book::Layout(const Song &song, vector<Page> &pages, SearchIndex *search)
+{
+	// Each song starts on a new page.
+	Page::SetTextSize(song.TextSize());
+	pages.emplace_back(pages.size() + 1);
+	AddTitle(song, pages.back());
+	if(search)
+		search->Add(song, pages.size() - 1);
+	
+	// Now, try to lay out each line of the song on the page.
+	for(const Line &line : song)
+	{
+		AddLine(line, pages);
+		if(search)
+			search->Add(line, pages.size() - 1);
+	}
+}
+
+
+
+// Insert the index pages at the given location, and then place all the page
+// numbers.
+void Book::Assemble(vector<Page> &pages, const vector<Page> &index, const string &indexLocation, const string &layout, SearchIndex *search)
+{
+	// Insert the index.
+	if(indexLocation == "front")
+	{
+		pages.insert(pages.begin(), index.begin(), index.end());
+		if(search)
+			search->Shift(index.size());
+	}
+	else if(indexLocation == "back")
+		pages.insert(pages.end(), index.begin(), index.end());
+	
+	// If there is only one page, don't number it.
+	if(pages.size() <= 1)
+		return;
+	
+	// Place all the page numbers. If this is a booklet, the numbers will
+	// alternate right and left sides, starting over with each volume.
+	// Otherwise they're all centered.
+	bool isBooklet = (layout == "booklet");
+	vector<size_t> volumeEnd;
+	int side = isBooklet;
+	for(size_t i = 0; i < pages.size(); ++i)
+	{
+		pages[i].PlaceNumber(side);
+		side = -side;
+		if(i + 1 == pages.size() || pages[i + 1].Volume() != pages[i].Volume())
+		{
+			volumeEnd.push_back(i + 1);
+			side = isBooklet;
+		}
+	}
+	// If the layout is booklet, the number of pages in each volume must be a
+	// multiple of four. Pad the last volume first, so the positions of the
+	// earlier ones do not change.
+	for(size_t v = volumeEnd.size(); isBooklet && v--; )
+	{
+		size_t begin = (v ? volumeEnd[v - 1] : 0);
+		size_t padding = (4 - (volumeEnd[v] - begin) % 4) % 4;
+		if(!padding)
+			continue;
+		
+		Page blank;
+		blank.SetVolume(pages[begin].Volume());
+		pages.insert(pages.begin() + volumeEnd[v], padding, blank);
+		if(search)
+			search->Shift(padding, volumeEnd[v]);
+	}
+}
+
+
+
+// Start a new section, beginning with the next song that is added.
+void Book::StartSection(const string &name)
+{
+	sections.emplace_back(size(), name);
+}
+
+
+
+// For each song, find the largest text size between the given limits at which
+// the whole song fits on a single page, and set that as the song's text size.
+void Book::Fit(double minSize, double maxSize)
+{
+	vector<Page> pages;
+	for(Song &song : *this)
+	{
+		// Most songs are short, so first check if the maximum size will work.
+		song.SetTextSize(maxSize);
+		if(FitsOnOnePage(song, pages))
+			continue;
+		
+		// Otherwise, do a binary search. Only the layout needs to be redone for
+		// each trial, because the fonts have already measured all the text.
+		double low = minSize;
+		double high = maxSize;
+		while(high - low > FIT_PRECISION)
+		{
+			song.SetTextSize(.5 * (low + high));
+			if(FitsOnOnePage(song, pages))
+				low = song.TextSize();
+			else
+				high = song.TextSize();
+		}
+		song.SetTextSize(low);
+	}
+	Page::SetTextSize(0.);
+}
+
+
+
+// Transpose every song by the given number of semitones from the key it was
+// written in.
+void Book::Transpose(int semitones)
+{
+	for(Song &song : *this)
+		song.Transpose(semitones);
+}
+
+namespace {
+	// Hash all the lines of a stanza.
+	size_t StanzaHash::operator()(const StanzaKey &key) const
+	{
+		size_t value = 0;
+		for(const Line *it = key.begin; it != key.end; ++it)
+			value = value * 31 + it->Hash();
+		return value;
+	}
+	
+	
+	
+	// Check if the given song fits on a single page at its current text size.
+	bool FitsOnOnePage(const Song &song, vector<Page> &pages)
+	{
+		pages.clear();
+		Book::Layout(song, pages);
+		return (pages.size() == 1);
+	}
+	
+	
+	
+	// Lay out the given lines of a song on a single slide, without wrapping
+	// any of them. A line has wrapped if the layout moved down in the middle
+	// of it, instead of only at the end.
+	bool FitsOnSlide(const Song &song, size_t begin, size_t end, bool hasTitle, Page &slide)
+	{
+		slide = Page();
+		if(hasTitle)
+			AddTitle(song, slide);
+		for(size_t i = begin; i < end; ++i)
+		{
+			double used = slide.Used();
+			if(!slide.Add(song[i]) || slide.Used() != used)
+				return false;
+			slide.EndLine(song[i]);
+		}
+		return !slide.Overflows();
+	}
+	
+	
+	
+	// Lay out the given lines of a song on their own slide, at the largest text
+	// size between the given limits at which they fit.
+	void FitSlide(const Song &song, size_t begin, size_t end, bool hasTitle, double minSize, double maxSize, vector<Page> &slides)
+	{
+		// Most stanzas are short, so first check if the maximum size will work.
+		// Otherwise, do a binary search, the same as for fitting a whole song.
+		Page slide;
+		Page::SetTextSize(maxSize);
+		if(!FitsOnSlide(song, begin, end, hasTitle, slide))
+		{
+			double low = minSize;
+			double high = maxSize;
+			while(high - low > FIT_PRECISION)
+			{
+				double size = .5 * (low + high);
+				Page::SetTextSize(size);
+				if(FitsOnSlide(song, begin, end, hasTitle, slide))
+					low = size;
+				else
+					high = size;
+			}
+			Page::SetTextSize(low);
+			if(!FitsOnSlide(song, begin, end, hasTitle, slide))
+			{
+				// This stanza is too long even at the minimum size, so let the
+				// lines wrap and continue onto as many slides as they need.
+				slides.emplace_back();
+				if(hasTitle)
+					AddTitle(song, slides.back());
+				for(size_t i = begin; i < end; ++i)
+					AddLine(song[i], slides);
+				return;
+			}
+		}
+		slides.push_back(move(slide));
+	}
+	
+	
+	
+	// Lay out the title block of the given song on the given page, and mark
+	// where it is for the PDF outline. Assume there's always space for the
+	// title and the subtitle, so we don't need to check if this succeeds. Also
+	// assume that every song has a title.
+	void AddTitle(const Song &song, Page &page)
+	{
+		page.AddBookmark(song.Title());
+		page.AddLine(TextType::TITLE, song.Title());
+		if(!song.Subtitle().empty())
+			page.AddLine(TextType::SUBTITLE, song.Subtitle());
+		page.EndTitle();
+	}
+	
+	
+	
+	// Lay out a line of a song, starting new pages as needed.
+	void AddLine(const Line &line, vector<Page> &pages)
+	{
+		// Most lines fit on the current page, and can be added all at once.
+		// Otherwise, the page break will be in the middle of this line.
+		if(!pages.back().Add(line))
+		{
+			pages.back().Indent(line.IsIndented());
+			for(const Block &block : line)
+			{
+				// If adding the block doesn't work, start a new page and add it
+				// there. Assume it always works the second time around.
+				for(int tries = 0; tries < 2; ++tries)
+				{
+					if(pages.back().Add(line, block))
+						break;
+					pages.emplace_back(pages.size() + 1);
+					// If we're still at the start of the line, indent.
+					if(&block == &line.front())
+						pages.back().Indent(line.IsIndented());
+				}
+			}
+		}
+		pages.back().EndLine(line);
+	}
+	
+	
+	
+	// Split the given song into stanzas, measuring the height of each one. The
+	// measurement is done by laying each stanza out on a blank page, which
+	// also reveals any stanza that is too tall to fit on one page.
+	void SplitStanzas(const Song &song, vector<Stanza> &stanzas)
+	{
+		Page::SetTextSize(song.TextSize());
+		vector<Page> scratch;
+		
+		size_t begin = 0;
+		do
+		{
+			// Find the end of this stanza: the first empty line after a line
+			// that is not empty.
+			size_t end = begin;
+			bool hasText = false;
+			for( ; end < song.size() && !(hasText && song[end].empty()); ++end)
+				hasText |= !song[end].empty();
+			size_t next = end;
+			while(next < song.size() && song[next].empty())
+				++next;
+			
+			scratch.clear();
+			scratch.emplace_back();
+			if(!begin)
+				AddTitle(song, scratch.back());
+			for(size_t i = begin; i < end; ++i)
+				AddLine(song[i], scratch);
+			double height = scratch.back().Used();
+			for(size_t i = end; i < next; ++i)
+				AddLine(song[i], scratch);
+			
+			// If this stanza does not fit on one page, each of its lines must
+			// be a separate unit instead, to allow breaks in the middle of it.
+			if(scratch.size() > 1 && end - begin > 1)
+			{
+				for(size_t i = begin; i < end; ++i)
+				{
+					scratch.clear();
+					scratch.emplace_back();
+					if(!i)
+						AddTitle(song, scratch.back());
+					AddLine(song[i], scratch);
+					height = scratch.back().Used();
+					size_t stop = (i + 1 == end ? next : i + 1);
+					for(size_t j = i + 1; j < stop; ++j)
+						AddLine(song[j], scratch);
+					stanzas.push_back({&song, i, stop, height, scratch.back().Used() - height});
+				}
+			}
+			else
+				stanzas.push_back({&song, begin, next, height, scratch.back().Used() - height});
+			begin = next;
+		} while(begin < song.size());
+	}
+	
+	
+	
+	// Measure the gap that separates the given song from the song before it.
+	// This is an empty line at that song's text size, since that is the size
+	// the page is at when the song is laid out.
+	double SongGap(const Song &song)
+	{
+		Page::SetTextSize(song.TextSize());
+		Page gapPage;
+		gapPage.EndLine(Line());
+		return gapPage.Used();
+	}
+	
+	
+	
+	// Choose the order of the songs so that short songs fill space left over
+	// at the ends of the pages of other songs. Finding the order that uses the
+	// fewest pages overall is a bin packing problem, which is too slow to
+	// solve exactly for a large book. Instead, songs are taken in their
+	// original order, and whenever a page has space left on it, a dynamic
+	// program picks the set of later short songs that fills that space best.
+	vector<const Song *> Reorder(const vector<const Song *> &songs)
+	{
+		// Only this many of the remaining songs are considered for each page,
+		// which keeps the songs close to their original order and bounds the
+		// time spent on each page.
+		const size_t CANDIDATES = 100;
+		const size_t NONE = numeric_limits<size_t>::max();
+		
+		// Figure out how tall each song is, if it can fit on one page, and how
+		// much space it needs if it follows another song on the same page.
+		// Also figure out how much of its last page each song fills if it
+		// starts on a new page, moving to a new page between stanzas.
+		double usable = Page::Usable();
+		vector<double> height;
+		vector<double> tail;
+		vector<double> gap;
+		vector<Stanza> stanzas;
+		for(const Song *song : songs)
+		{
+			stanzas.clear();
+			SplitStanzas(*song, stanzas);
+			double used = 0.;
+			bool isShort = true;
+			for(size_t i = 0; i < stanzas.size(); ++i)
+			{
+				double top = (i ? used + stanzas[i - 1].gap : 0.);
+				isShort &= (top + stanzas[i].height <= usable);
+				used = (top + stanzas[i].height <= usable ? top : 0.) + stanzas[i].height;
+			}
+			height.push_back(isShort ? used : numeric_limits<double>::infinity());
+			tail.push_back(min(used, usable));
+			gap.push_back(SongGap(*song));
+		}
+		Page::SetTextSize(0.);
+		
+		vector<const Song *> order;
+		vector<bool> isUsed(songs.size(), false);
+		size_t next = 0;
+		vector<size_t> candidates;
+		vector<size_t> sizes;
+		vector<size_t> count;
+		vector<bool> taken;
+		while(order.size() < songs.size())
+		{
+			// Start a new page with the next song in the original order.
+			while(isUsed[next])
+				++next;
+			isUsed[next] = true;
+			order.push_back(songs[next]);
+			
+			// Find the later songs that could fit in the space left on the
+			// last page of that song. Sizes are rounded up to whole points, so
+			// the chosen songs are sure to fit.
+			size_t space = static_cast<size_t>(usable - tail[next]);
+			candidates.clear();
+			sizes.clear();
+			for(size_t i = next + 1; i < songs.size() && candidates.size() < CANDIDATES; ++i)
+				if(!isUsed[i] && gap[i] + height[i] <= space)
+				{
+					candidates.push_back(i);
+					sizes.push_back(max<size_t>(1, static_cast<size_t>(ceil(gap[i] + height[i]))));
+				}
+			if(candidates.empty())
+				continue;
+			
+			// For each amount of space, find the fewest candidates that fill
+			// exactly that much space, remembering which candidates were
+			// taken at each step. Using as few songs as possible saves the
+			// shortest ones to fill in the gaps on later pages.
+			size_t width = space + 1;
+			count.assign(width, NONE);
+			count[0] = 0;
+			taken.assign(candidates.size() * width, false);
+			for(size_t k = 0; k < candidates.size(); ++k)
+				for(size_t filled = space; filled >= sizes[k]; --filled)
+					if(count[filled - sizes[k]] != NONE && count[filled - sizes[k]] + 1 < count[filled])
+					{
+						count[filled] = count[filled - sizes[k]] + 1;
+						taken[k * width + filled] = true;
+					}
+			
+			// Put the set that fills the most space on this page, keeping the
+			// songs in that set in their original order.
+			size_t filled = space;
+			while(count[filled] == NONE)
+				--filled;
+			size_t first = order.size();
+			for(size_t k = candidates.size(); k--; )
+				if(taken[k * width + filled])
+				{
+					isUsed[candidates[k]] = true;
+					order.push_back(songs[candidates[k]]);
+					filled -= sizes[k];
+				}
+			reverse(order.begin() + first, order.end());
+		}
+		return order;
+	}
+	
+	
+	
+	// Choose which stanzas start a new page. This is a dynamic program over
+	// the possible break points: for each stanza, find the best way to lay out
+	// everything before it, given that it starts a new page.
+	vector<bool> ChooseBreaks(const vector<Stanza> &stanzas)
+	{
+		const size_t NONE = numeric_limits<size_t>::max();
+		double usable = Page::Usable();
+		
+		// Measure the gap before each song, at the text size that song will
+		// be laid out at.
+		size_t count = stanzas.size();
+		vector<double> songGap(count, 0.);
+		for(size_t i = 0; i < count; ++i)
+			if(!stanzas[i].begin)
+				songGap[i] = SongGap(*stanzas[i].song);
+		
+		// For each possible break point, store the fewest pages and page turns
+		// needed to get there, and the previous break point on that path.
+		vector<size_t> pages(count + 1, NONE);
+		vector<size_t> turns(count + 1, NONE);
+		vector<size_t> previous(count + 1, NONE);
+		pages[0] = 0;
+		turns[0] = 0;
+		for(size_t i = 0; i < count; ++i)
+		{
+			if(pages[i] == NONE)
+				continue;
+			// Breaking in the middle of a song means a page turn.
+			size_t turn = turns[i] + (stanzas[i].begin != 0);
+			// Put stanzas on the page starting with this one until it is full.
+			// A single stanza is always allowed, even if it doesn't fit.
+			double height = stanzas[i].height;
+			for(size_t j = i + 1; j <= count; ++j)
+			{
+				if(j != i + 1)
+				{
+					height += stanzas[j - 2].gap + stanzas[j - 1].height;
+					height += songGap[j - 1];
+					if(height > usable)
+						break;
+				}
+				if(pages[i] + 1 < pages[j] || (pages[i] + 1 == pages[j] && turn < turns[j]))
+				{
+					pages[j] = pages[i] + 1;
+					turns[j] = turn;
+					previous[j] = i;
+				}
+			}
+		}
+		
+		// Trace the chosen path back from the end.
+		vector<bool> breaks(count, false);
+		for(size_t j = count; j && previous[j] != NONE; j = previous[j])
+			breaks[previous[j]] = true;
+		return breaks;
+	}
+	
+	
+	
+	// Choose which pages start a new volume. Each volume ends just before the
+	// last song that starts within its page limit, unless no song starts
+	// there, in which case it ends right at the limit.
+	vector<size_t> ChooseVolumes(const vector<size_t> &firstPage, size_t pages, size_t perVolume)
+	{
+		vector<size_t> starts;
+		size_t start = 0;
+		size_t lastSong = 0;
+		for(size_t i = 0; i <= firstPage.size(); ++i)
+		{
+			size_t next = (i < firstPage.size() ? firstPage[i] : pages);
+			while(next - start > perVolume)
+			{
+				start = (lastSong > start ? lastSong : start + perVolume);
+				starts.push_back(start);
+			}
+			lastSong = next;
+		}
+		return starts;
+	}
+}
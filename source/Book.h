@@ -0,0 +1,96 @@
+/* Book.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef BOOK_H_
+#define BOOK_H_
+
+#include "Page.h"
+#include "SearchIndex.h"
+#include "Song.h"
+
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+
+// This represents a collection of parsed songs. The songs are kept around so
+// that they can be laid out again whenever a setting changes: just call
+// Page::Init() with the new configuration and then Layout() again. Nothing
+// needs to be re-parsed, and text widths are cached by the fonts, so redoing
+// the layout is cheap enough for an interactive preview.
+class Book : public vector<Song> {
+public:
+	// Add all the songs in the given file or stream (which may hold several
+	// songs) to the end of the book. Songs with no title are skipped.
+	void Load(const string &path);
+	void Load(istream &in, bool isChordPro = false);
+	
+	// Lay out the songs on pages, including possibly pages at the start or end
+	// for the table of contents. Packing may be "none" (each song starts on a
+	// new page), "pack" (short songs may share a page, and page breaks are
+	// chosen to use as few pages as possible), or "reorder" (like "pack", but
+	// also moving short songs into space left over at the end of other songs).
+	// The book may be split into volumes: "none", "sections" (each section
+	// starts a new volume), or a number of pages per volume. Volumes only
+	// break where a song starts, unless one song is longer than a volume. The
+	// page numbers continue from one volume to the next, each page's Volume()
+	// says which one it belongs to, and the index lists volume and page. The
+	// index may be sorted (see Contents). If a search index is given, the words
+	// of every line are added to it.
+	vector<Page> Layout(const string &indexLocation, const string &layout, const string &packing = "none", const string &volumes = "none", const string &indexSort = "none", SearchIndex *search = nullptr) const;
+	
+	// Lay out the songs as slides for a projector instead of as a book. Each
+	// stanza gets its own slide, at the largest text size between the given
+	// limits at which it fits without wrapping any lines, and the first slide
+	// of each song also has its title. A stanza that is still too long at the
+	// minimum size wraps onto more slides. Stanzas that appear more than once,
+	// such as a chorus, are only fitted once. The slides' numbers are only
+	// used to name their bookmarks, and are never shown.
+	vector<Page> Slides(double minSize, double maxSize, SearchIndex *search = nullptr) const;
+	
+	// Lay out a single song, starting on a new page at the end of the given
+	// list of pages. This is all that needs to be redone if one song changes.
+	static void Layout(const Song &song, vector<Page> &pages, SearchIndex *search = nullptr);
+	// Insert the index pages at the given location ("front", "back", or
+	// "none"), and then place all the page numbers. If the layout is
+	// "booklet", each volume is padded to a multiple of four pages.
+	static void Assemble(vector<Page> &pages, const vector<Page> &index, const string &indexLocation, const string &layout, SearchIndex *search = nullptr);
+	
+	// Start a new section, beginning with the next song that is added. Each
+	// section starts on a new page, and its name is listed in the index.
+	void StartSection(const string &name);
+	
+	// For each song, find the largest text size between the given limits at
+	// which the whole song fits on a single page, and set that as the song's
+	// text size. Songs that are too long even at the minimum size get the
+	// minimum size.
+	void Fit(double minSize, double maxSize);
+	
+	// Transpose every song by the given number of semitones from the key it
+	// was written in. Only the chord text changes, so the cached widths of
+	// all the lyrics are still valid, and each chord that was already seen in
+	// the new key is looked up rather than transposed again.
+	void Transpose(int semitones);
+	
+	
+private:
+	// The name of each section, and the index of the first song in it.
+	vector<pair<size_t, string>> sections;
+};
+
+
+
+#endif
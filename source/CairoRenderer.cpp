@@ -0,0 +1,150 @@
+/* CairoRenderer.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+
+#include "CairoRenderer.h"
+
+#include <cairo-pdf.h>
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	// Function to write output to STDOUT instead of to a named file.
+	Cairo::ErrorStatus Write(const unsigned char *data, unsigned int length);
+	// Quote a string to be used as the value of a cairo tag attribute.
+	string Quote(const string &text);
+}
+
+
+
+// Draw into the given context.
+CairoRenderer::CairoRenderer(const Cairo::RefPtr<Cairo::Context> &context)
+	: context(context)
+{
+}
+
+
+
+// Write a PDF with sheets of the given size to the given path, or to STDOUT if
+// the path is empty.
+CairoRenderer::CairoRenderer(const string &path, double width, double height)
+{
+	if(path.empty())
+		pdf = Cairo::PdfSurface::create_for_stream(&Write, width, height);
+	else
+		pdf = Cairo::PdfSurface::create(path, width, height);
+	context = Cairo::Context::create(pdf);
+}
+
+
+
+void CairoRenderer::DrawText(const Font &font, const string &text, double x, double y, double scale, double width)
+{
+	font.Draw(text, context, x, y, scale);
+}
+
+
+
+void CairoRenderer::DrawLeader(double fromX, double toX, double y)
+{
+	vector<double> pattern = {1., 7.};
+	context->set_dash(pattern, 0.);
+	context->set_line_width(1);
+	
+	context->move_to(fromX, y);
+	context->line_to(toX, y);
+	context->stroke();
+}
+
+
+
+void CairoRenderer::EndSheet()
+{
+	context->show_page();
+}
+
+
+
+void CairoRenderer::AddDestination(const string &name, double x, double y)
+{
+#if CAIRO_VERSION >= CAIRO_VERSION_ENCODE(1, 16, 0)
+	if(!pdf || !destinations.insert(name).second)
+		return;
+	
+	string attributes = "name=" + Quote(name) + " x=" + to_string(x) + " y=" + to_string(y);
+	cairo_tag_begin(context->cobj(), CAIRO_TAG_DEST, attributes.c_str());
+	cairo_tag_end(context->cobj(), CAIRO_TAG_DEST);
+#endif
+}
+
+
+
+void CairoRenderer::AddLink(double x, double y, double width, double height, const string &destination)
+{
+#if CAIRO_VERSION >= CAIRO_VERSION_ENCODE(1, 16, 0)
+	if(!pdf)
+		return;
+	
+	string attributes = "dest=" + Quote(destination) + " rect=[" + to_string(x) + " " + to_string(y)
+		+ " " + to_string(width) + " " + to_string(height) + "]";
+	cairo_tag_begin(context->cobj(), CAIRO_TAG_LINK, attributes.c_str());
+	cairo_tag_end(context->cobj(), CAIRO_TAG_LINK);
+#endif
+}
+
+
+
+void CairoRenderer::AddOutline(const string &title, int level, const string &destination)
+{
+#if CAIRO_VERSION >= CAIRO_VERSION_ENCODE(1, 16, 0)
+	if(!pdf)
+		return;
+	
+	// Sections are left open, so their songs are shown.
+	string attributes = "dest=" + Quote(destination);
+	int parent = (level ? section : CAIRO_PDF_OUTLINE_ROOT);
+	int id = cairo_pdf_surface_add_outline(pdf->cobj(), parent, title.c_str(), attributes.c_str(),
+		level ? static_cast<cairo_pdf_outline_flags_t>(0) : CAIRO_PDF_OUTLINE_FLAG_OPEN);
+	if(!level)
+		section = id;
+#endif
+}
+
+
+
+namespace {
+	// Function to write output to STDOUT instead of to a named file.
+	Cairo::ErrorStatus Write(const unsigned char *data, unsigned int length)
+	{
+		cout.write(reinterpret_cast<const char *>(data), length);
+		return CAIRO_STATUS_SUCCESS;
+	}
+	
+	
+	
+	// Quote a string to be used as the value of a cairo tag attribute, with a
+	// backslash before any quote or backslash in it.
+	string Quote(const string &text)
+	{
+		string result = "'";
+		for(char c : text)
+		{
+			if(c == '\\' || c == '\'')
+				result += '\\';
+			result += c;
+		}
+		return result + "'";
+	}
+}
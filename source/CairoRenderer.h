@@ -0,0 +1,63 @@
+/* CairoRenderer.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+
+#ifndef CAIRO_RENDERER_H_
+#define CAIRO_RENDERER_H_
+
+#include "Renderer.h"
+
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+
+#include <set>
+#include <string>
+
+using namespace std;
+
+
+
+// Renderer that draws with cairo, either into a PDF file or into any cairo
+// context that the caller has set up (such as an image, for previews).
+class CairoRenderer : public Renderer {
+public:
+	// Draw into the given context. Ending a sheet shows the current page.
+	explicit CairoRenderer(const Cairo::RefPtr<Cairo::Context> &context);
+	// Write a PDF with sheets of the given size to the given path, or to
+	// STDOUT if the path is empty.
+	CairoRenderer(const string &path, double width, double height);
+	
+	virtual void DrawText(const Font &font, const string &text, double x, double y, double scale, double width) override;
+	virtual void DrawLeader(double fromX, double toX, double y) override;
+	virtual void EndSheet() override;
+	
+	// Links and the outline are only written to a PDF, and only if cairo is
+	// new enough to support them (version 1.16).
+	virtual void AddDestination(const string &name, double x, double y) override;
+	virtual void AddLink(double x, double y, double width, double height, const string &destination) override;
+	virtual void AddOutline(const string &title, int level, const string &destination) override;
+	
+	
+private:
+	Cairo::RefPtr<Cairo::Context> context;
+	// The PDF surface, if this is writing a PDF.
+	Cairo::RefPtr<Cairo::PdfSurface> pdf;
+	// The names of the destinations that have been added, because each one
+	// may only be defined once.
+	set<string> destinations;
+	// The outline entry that songs are currently being added under.
+	int section = 0;
+};
+
+
+
+#endif
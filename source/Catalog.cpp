@@ -0,0 +1,359 @@
+/* Catalog.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Catalog.h"
+
+#include "Song.h"
+#include "ThreadPool.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+using namespace std;
+
+namespace {
+	// The file starts with a header, followed by a record for each song, a
+	// record for each term (sorted by the term's text), the list of songs for
+	// each term, and then all the text, as null-terminated strings. Every
+	// number is 32 bits, so each part of the file is aligned.
+	const char MAGIC[8] = {'R', 'E', 'C', 'H', 'C', 'A', 'T', '1'};
+	class Header {
+	public:
+		char magic[8];
+		uint32_t songs;
+		uint32_t terms;
+		uint32_t postings;
+		uint32_t text;
+	};
+	// The text fields are offsets into the text.
+	class SongRecord {
+	public:
+		uint32_t path;
+		uint32_t title;
+		uint32_t subtitle;
+	};
+	// The songs that have a term are a range in the list of songs.
+	class TermRecord {
+	public:
+		uint32_t text;
+		uint32_t first;
+		uint32_t count;
+	};
+	
+	// The information about one song that goes in the catalog.
+	class Entry {
+	public:
+		string path;
+		string title;
+		string subtitle;
+		map<string, string> metadata;
+		string sortKey;
+	};
+	
+	// Split the given text into words, converting them to lower case, and add
+	// a "field:word" term for each one to the given map.
+	void AddTerms(const string &field, const string &text, uint32_t song, map<string, vector<uint32_t>> &terms);
+	// Check if the given character is part of a word. Anything that is not
+	// ASCII is assumed to be a letter. '#' is included for keys like "F#".
+	bool IsWordChar(char c);
+	// Add the given string to the text, and return its offset.
+	uint32_t AddText(const string &str, string &text);
+}
+
+
+
+// Read all the given song files, in parallel, and write a catalog of them to
+// the given path.
+bool Catalog::Build(const vector<string> &songPaths, const string &path)
+{
+	// Only the headers are needed, but reading the whole song is the only way
+	// to be sure that it is valid.
+	vector<Entry> entries(songPaths.size());
+	{
+		ThreadPool pool;
+		for(size_t i = 0; i < songPaths.size(); ++i)
+			pool.Add([&songPaths, &entries, i]()
+			{
+				Song song(songPaths[i]);
+				if(song.empty() || song.Title().empty())
+					return;
+			
+				// Store the full path, so the catalog can be used from anywhere.
+				Entry &entry = entries[i];
+				char fullPath[PATH_MAX];
+				entry.path = realpath(songPaths[i].c_str(), fullPath) ? fullPath : songPaths[i];
+				entry.title = song.Title();
+				entry.subtitle = song.Subtitle();
+				entry.metadata = song.Metadata();
+				for(char c : entry.title)
+					entry.sortKey += (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+			});
+	}
+	entries.erase(remove_if(entries.begin(), entries.end(),
+		[](const Entry &entry) { return entry.path.empty(); }), entries.end());
+	// Sort the songs by title, so that query results are in that order too.
+	stable_sort(entries.begin(), entries.end(),
+		[](const Entry &a, const Entry &b) { return a.sortKey < b.sortKey; });
+	
+	// Find all the terms.
+	map<string, vector<uint32_t>> terms;
+	for(uint32_t i = 0; i < entries.size(); ++i)
+	{
+		const Entry &entry = entries[i];
+		AddTerms("title", entry.title, i, terms);
+		AddTerms("subtitle", entry.subtitle, i, terms);
+		for(const pair<const string, string> &it : entry.metadata)
+			AddTerms(it.first, it.second, i, terms);
+	}
+	
+	// Convert everything into the file format.
+	string text;
+	vector<SongRecord> songs;
+	for(const Entry &entry : entries)
+		songs.push_back({AddText(entry.path, text), AddText(entry.title, text), AddText(entry.subtitle, text)});
+	vector<TermRecord> termRecords;
+	vector<uint32_t> postings;
+	for(const pair<const string, vector<uint32_t>> &it : terms)
+	{
+		termRecords.push_back({AddText(it.first, text), static_cast<uint32_t>(postings.size()),
+			static_cast<uint32_t>(it.second.size())});
+		postings.insert(postings.end(), it.second.begin(), it.second.end());
+	}
+	
+	Header header;
+	copy(begin(MAGIC), end(MAGIC), header.magic);
+	header.songs = songs.size();
+	header.terms = termRecords.size();
+	header.postings = postings.size();
+	header.text = text.size();
+	
+	ofstream out(path, ios::binary);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char *>(songs.data()), songs.size() * sizeof(SongRecord));
+	out.write(reinterpret_cast<const char *>(termRecords.data()), termRecords.size() * sizeof(TermRecord));
+	out.write(reinterpret_cast<const char *>(postings.data()), postings.size() * sizeof(uint32_t));
+	out.write(text.data(), text.size());
+	return static_cast<bool>(out);
+}
+
+
+
+// Open the catalog with the given path.
+Catalog::Catalog(const string &path)
+{
+	int file = open(path.c_str(), O_RDONLY);
+	if(file < 0)
+		return;
+	
+	struct stat info;
+	if(!fstat(file, &info) && static_cast<size_t>(info.st_size) >= sizeof(Header))
+	{
+		void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+		if(mapped != MAP_FAILED)
+		{
+			data = static_cast<const char *>(mapped);
+			size = info.st_size;
+		}
+	}
+	close(file);
+	
+	// Make sure this is actually a catalog, and that it is not truncated.
+	if(data)
+	{
+		const Header &header = *reinterpret_cast<const Header *>(data);
+		size_t expected = sizeof(Header) + header.songs * sizeof(SongRecord)
+			+ header.terms * sizeof(TermRecord) + header.postings * sizeof(uint32_t) + header.text;
+		if(!equal(begin(MAGIC), end(MAGIC), header.magic) || expected != size)
+		{
+			munmap(const_cast<char *>(data), size);
+			data = nullptr;
+			size = 0;
+		}
+	}
+}
+
+
+
+Catalog::~Catalog()
+{
+	if(data)
+		munmap(const_cast<char *>(data), size);
+}
+
+
+
+// Check if the catalog was found and is valid.
+bool Catalog::IsOpen() const
+{
+	return data;
+}
+
+
+
+// Get the number of songs in the catalog.
+size_t Catalog::Size() const
+{
+	return data ? reinterpret_cast<const Header *>(data)->songs : 0;
+}
+
+
+
+// Get the paths of all the songs that match the given query, sorted by title.
+vector<string> Catalog::Find(const string &query) const
+{
+	vector<string> paths;
+	if(!data)
+		return paths;
+	
+	const Header &header = *reinterpret_cast<const Header *>(data);
+	const SongRecord *songs = reinterpret_cast<const SongRecord *>(data + sizeof(Header));
+	const char *text = data + size - header.text;
+	
+	// Songs are numbered in title order, so keeping each list of songs sorted
+	// by number means the result is in title order too.
+	vector<uint32_t> result;
+	vector<uint32_t> excluded;
+	vector<uint32_t> matches;
+	vector<uint32_t> merged;
+	bool hasTerms = false;
+	for(size_t start = 0; start < query.length(); )
+	{
+		size_t end = min(query.find(' ', start), query.length());
+		string term = query.substr(start, end - start);
+		start = end + 1;
+		size_t colon = term.find(':');
+		if(colon == string::npos)
+			continue;
+		
+		bool isExcluded = (term[0] == '-');
+		string field = term.substr(isExcluded, colon - isExcluded);
+		
+		// Find all the songs that match any of the comma-separated words.
+		matches.clear();
+		for(size_t wordStart = colon + 1; wordStart < term.length(); )
+		{
+			size_t wordEnd = min(term.find(',', wordStart), term.length());
+			string word;
+			for(size_t i = wordStart; i < wordEnd; ++i)
+				if(IsWordChar(term[i]))
+					word += (term[i] >= 'A' && term[i] <= 'Z') ? term[i] + ('a' - 'A') : term[i];
+			wordStart = wordEnd + 1;
+			
+			vector<uint32_t> songList = Songs(field + ':' + word);
+			merged.clear();
+			set_union(matches.begin(), matches.end(), songList.begin(), songList.end(), back_inserter(merged));
+			matches.swap(merged);
+		}
+		
+		if(isExcluded)
+		{
+			merged.clear();
+			set_union(excluded.begin(), excluded.end(), matches.begin(), matches.end(), back_inserter(merged));
+			excluded.swap(merged);
+		}
+		else if(!hasTerms)
+		{
+			result.swap(matches);
+			hasTerms = true;
+		}
+		else
+		{
+			merged.clear();
+			set_intersection(result.begin(), result.end(), matches.begin(), matches.end(), back_inserter(merged));
+			result.swap(merged);
+		}
+	}
+	// A query with only exclusions starts with every song.
+	if(!hasTerms)
+		for(uint32_t i = 0; i < header.songs; ++i)
+			result.push_back(i);
+	
+	merged.clear();
+	set_difference(result.begin(), result.end(), excluded.begin(), excluded.end(), back_inserter(merged));
+	for(uint32_t song : merged)
+		paths.emplace_back(text + songs[song].path);
+	return paths;
+}
+
+
+
+// Get the sorted list of songs that have the given "field:word" term.
+vector<uint32_t> Catalog::Songs(const string &term) const
+{
+	const Header &header = *reinterpret_cast<const Header *>(data);
+	const char *records = data + sizeof(Header) + header.songs * sizeof(SongRecord);
+	const TermRecord *terms = reinterpret_cast<const TermRecord *>(records);
+	const uint32_t *postings = reinterpret_cast<const uint32_t *>(records + header.terms * sizeof(TermRecord));
+	const char *text = data + size - header.text;
+	
+	// The terms are sorted, so use a binary search.
+	const TermRecord *it = lower_bound(terms, terms + header.terms, term,
+		[text](const TermRecord &record, const string &key) { return strcmp(text + record.text, key.c_str()) < 0; });
+	if(it == terms + header.terms || term != text + it->text)
+		return vector<uint32_t>();
+	return vector<uint32_t>(postings + it->first, postings + it->first + it->count);
+}
+
+
+
+namespace {
+	// Split the given text into words, converting them to lower case, and add
+	// a "field:word" term for each one to the given map.
+	void AddTerms(const string &field, const string &text, uint32_t song, map<string, vector<uint32_t>> &terms)
+	{
+		string term = field + ':';
+		size_t prefix = term.length();
+		for(size_t i = 0; i <= text.length(); ++i)
+		{
+			if(i < text.length() && IsWordChar(text[i]))
+				term += (text[i] >= 'A' && text[i] <= 'Z') ? text[i] + ('a' - 'A') : text[i];
+			else if(term.length() > prefix)
+			{
+				// A word may occur more than once in the same song.
+				vector<uint32_t> &songs = terms[term];
+				if(songs.empty() || songs.back() != song)
+					songs.push_back(song);
+				term.resize(prefix);
+			}
+		}
+	}
+	
+	
+	
+	// Check if the given character is part of a word.
+	bool IsWordChar(char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+			|| c == '#' || (c & 0x80);
+	}
+	
+	
+	
+	// Add the given string to the text, and return its offset.
+	uint32_t AddText(const string &str, string &text)
+	{
+		uint32_t offset = text.size();
+		text += str;
+		text += '\0';
+		return offset;
+	}
+}
@@ -0,0 +1,72 @@
+/* Catalog.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef CATALOG_H_
+#define CATALOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+
+// A catalog is a compact index of a library of song files, which can be
+// searched by title and metadata without opening any of the songs. It is
+// written once by "re-chord index" and then memory mapped whenever it is used,
+// so a query only reads the parts of the file that it needs.
+//
+// A query is a list of terms separated by spaces, and a song must match all of
+// them. Each term is "field:word", where the field is "title", "subtitle", or
+// a metadata key such as "key", "tag", or "author"; it matches any song with
+// that word in that field. "field:a,b" matches either word, and "-field:word"
+// excludes the songs that match.
+class Catalog {
+public:
+	// Read all the given song files, in parallel, and write a catalog of them
+	// to the given path. This returns false if the catalog can't be written.
+	static bool Build(const vector<string> &songPaths, const string &path);
+	
+	
+public:
+	explicit Catalog(const string &path);
+	// Don't allow copying.
+	Catalog(const Catalog &) = delete;
+	Catalog &operator=(const Catalog &) = delete;
+	~Catalog();
+	
+	// Check if the catalog was found and is valid.
+	bool IsOpen() const;
+	// Get the number of songs in the catalog.
+	size_t Size() const;
+	
+	// Get the paths of all the songs that match the given query, sorted by
+	// title.
+	vector<string> Find(const string &query) const;
+	
+	
+private:
+	// Get the sorted list of songs that have the given "field:word" term.
+	vector<uint32_t> Songs(const string &term) const;
+	
+	
+private:
+	// The memory mapped file.
+	const char *data = nullptr;
+	size_t size = 0;
+};
+
+
+
+#endif
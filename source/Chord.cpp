@@ -0,0 +1,192 @@
+/* Chord.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Chord.h"
+
+#include "StringTable.h"
+
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+	// The parsed form of every chord that has been seen, by ID.
+	unordered_map<uint32_t, Chord> chords;
+	// For each transposition (1 to 11 semitones up), the ID each chord maps to.
+	unordered_map<uint32_t, uint32_t> transposed[12];
+	mutex tableLock;
+	
+	// Note names to use when transposing. If the original chord did not have a
+	// sharp or flat, use whichever spelling is more common for that note.
+	const char *SHARP[12] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+	const char *FLAT[12] = {"C", "Db", "D", "Eb", "E", "F", "Gb", "G", "Ab", "A", "Bb", "B"};
+	const char *NATURAL[12] = {"C", "C#", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B"};
+	
+	// Parse a note name at the given position in the given string, advancing
+	// the position past it. Return -1 if there is no note name there.
+	int ParseNote(const string &text, size_t &pos, bool &flats, bool &sharps);
+	// Check if the given part of a chord symbol is made up entirely of the
+	// words and symbols that can follow a chord's root note.
+	bool IsQuality(const string &text, size_t begin, size_t end);
+}
+
+
+
+// Get the ID of the given chord symbol, adding it to the table if needed.
+uint32_t Chord::Intern(const string &text)
+{
+	uint32_t id = StringTable::Intern(text);
+	
+	lock_guard<mutex> guard(tableLock);
+	if(!chords.count(id))
+		chords.emplace(id, Chord(text));
+	return id;
+}
+
+
+
+// Get the text of the chord with the given ID.
+const string &Chord::Text(uint32_t id)
+{
+	return StringTable::Get(id);
+}
+
+
+
+// Get the ID of the given chord transposed by the given number of semitones.
+uint32_t Chord::Transpose(uint32_t id, int semitones)
+{
+	semitones = ((semitones % 12) + 12) % 12;
+	if(!semitones)
+		return id;
+	
+	lock_guard<mutex> guard(tableLock);
+	auto it = chords.find(id);
+	if(it == chords.end() || it->second.root < 0)
+		return id;
+	
+	// Check if this transposition has already been done.
+	unordered_map<uint32_t, uint32_t> &remap = transposed[semitones];
+	auto rit = remap.find(id);
+	if(rit != remap.end())
+		return rit->second;
+	
+	// Build the text of the transposed chord.
+	const Chord &chord = it->second;
+	const char **names = (chord.flats ? FLAT : chord.sharps ? SHARP : NATURAL);
+	string text = names[(chord.root + semitones) % 12] + chord.quality;
+	if(chord.bass >= 0)
+		text += string("/") + names[(chord.bass + semitones) % 12];
+	
+	uint32_t result = StringTable::Intern(text);
+	remap[id] = result;
+	return result;
+}
+
+
+
+// Parse the given chord symbol.
+Chord::Chord(const string &text)
+{
+	size_t pos = 0;
+	root = ParseNote(text, pos, flats, sharps);
+	if(root < 0)
+		return;
+	
+	// Check if the chord ends with a bass note. If the text after the last
+	// slash is not a note name, the slash is part of the quality instead.
+	size_t slash = text.rfind('/');
+	size_t end = text.length();
+	if(slash != string::npos && slash >= pos)
+	{
+		size_t bassPos = slash + 1;
+		int note = ParseNote(text, bassPos, flats, sharps);
+		if(note >= 0 && bassPos == text.length())
+		{
+			bass = note;
+			end = slash;
+		}
+	}
+	// If the rest of the text is not a chord quality, this is just a word that
+	// happens to start with a note name, such as "Chorus", and it must never
+	// be transposed.
+	if(!IsQuality(text, pos, end))
+	{
+		root = -1;
+		bass = -1;
+		return;
+	}
+	quality = text.substr(pos, end - pos);
+}
+
+
+
+namespace {
+	// Parse a note name at the given position in the given string, advancing
+	// the position past it. Return -1 if there is no note name there.
+	int ParseNote(const string &text, size_t &pos, bool &flats, bool &sharps)
+	{
+		static const int SEMITONES[7] = {9, 11, 0, 2, 4, 5, 7};
+		if(pos >= text.length() || text[pos] < 'A' || text[pos] > 'G')
+			return -1;
+		
+		int note = SEMITONES[text[pos++] - 'A'];
+		if(pos < text.length() && text[pos] == '#')
+		{
+			sharps = true;
+			++note;
+			++pos;
+		}
+		else if(pos < text.length() && text[pos] == 'b')
+		{
+			flats = true;
+			note += 11;
+			++pos;
+		}
+		return note % 12;
+	}
+	
+	
+	
+	// Check if the given part of a chord symbol is a chord quality, such as
+	// "m7b5", "sus4", "maj7(#11)", or "6/9". Spaces are allowed only at the end.
+	bool IsQuality(const string &text, size_t begin, size_t end)
+	{
+		// Longer words must come before any word that they start with.
+		static const string WORDS[] = {"maj", "min", "dim", "aug", "sus", "add", "alt", "omit", "no",
+			"M", "m", "o", "\xC2\xB0", "\xC3\xB8", "\xCE\x94"};
+		static const string SYMBOLS = "0123456789#b+-()/,";
+		
+		while(end > begin && text[end - 1] == ' ')
+			--end;
+		while(begin < end)
+		{
+			if(SYMBOLS.find(text[begin]) != string::npos)
+			{
+				++begin;
+				continue;
+			}
+			bool found = false;
+			for(const string &word : WORDS)
+				if(!text.compare(begin, word.length(), word) && begin + word.length() <= end)
+				{
+					begin += word.length();
+					found = true;
+					break;
+				}
+			if(!found)
+				return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,56 @@
+/* Chord.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef CHORD_H_
+#define CHORD_H_
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+
+
+// This represents a chord symbol, split into its root note, its quality (the
+// "m7" in "Am7/G"), and an optional bass note. Each distinct chord is parsed
+// only once and stored in a table, so that chords can be referred to by ID and
+// transposing a chord is just a lookup of another ID. A chord's ID is the ID
+// of its text in the StringTable. Text that is not a chord symbol (e.g. "N.C."
+// or "Chorus") is kept as-is and never transposed. All of these functions are
+// safe to call from more than one thread.
+class Chord {
+public:
+	// Get the ID of the given chord symbol, adding it to the table if needed.
+	static uint32_t Intern(const string &text);
+	// Get the text of the chord with the given ID.
+	static const string &Text(uint32_t id);
+	// Get the ID of the given chord transposed by the given number of semitones.
+	static uint32_t Transpose(uint32_t id, int semitones);
+	
+	
+private:
+	explicit Chord(const string &text);
+	
+	
+private:
+	// The root and bass are semitones above C, or -1 if not present.
+	int root = -1;
+	string quality;
+	int bass = -1;
+	// Whether this chord was written with flats instead of sharps.
+	bool flats = false;
+	bool sharps = false;
+};
+
+
+
+#endif
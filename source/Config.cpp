@@ -75,6 +75,15 @@ void Config::Load(istream &in)
 
 
 
+// Write all the values to the given stream.
+void Config::Save(ostream &out) const
+{
+	for(const pair<const string, string> &it : values)
+		out << it.first << ": " << it.second << '\n';
+}
+
+
+
 // Check if the config includes a value for the given key.
 bool Config::Has(const string &key) const
 {
@@ -116,6 +125,22 @@ double Config::Value(const string &key, const string &defaultValue) const
 
 
 
+// Set the value of the given key, replacing any previous value.
+void Config::Set(const string &key, const string &value)
+{
+	values[key] = value;
+}
+
+
+
+// Check if two configurations have exactly the same values.
+bool Config::operator==(const Config &other) const
+{
+	return values == other.values;
+}
+
+
+
 // Helper functions:
 namespace {
 	// Parse the given string as a number in the format [-]<digit>*[.<digit>*].
@@ -15,6 +15,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <istream>
 #include <map>
+#include <ostream>
 #include <string>
 
 using namespace std;
@@ -32,6 +33,9 @@ public:
 	// Load from the given path or input stream.
 	void Load(const string &path);
 	void Load(istream &in);
+	// Write all the values to the given stream, in the same format they are
+	// loaded from.
+	void Save(ostream &out) const;
 	
 	// Check if the config includes a value for the given key.
 	bool Has(const string &key) const;
@@ -41,6 +45,11 @@ public:
 	double Value(const string &key, double defaultValue = 0.) const;
 	double Value(const string &key, const string &defaultValue = "") const;
 	
+	// Set the value of the given key, replacing any previous value.
+	void Set(const string &key, const string &value);
+	// Check if two configurations have exactly the same values.
+	bool operator==(const Config &other) const;
+	
 	
 private:
 	map<string, string> values;
@@ -0,0 +1,200 @@
+/* Contents.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Contents.h"
+
+#include "Unicode.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+	// Get the key that sorts the given text according to the locale.
+	string CollationKey(const string &text);
+}
+
+
+
+// Create an index, sorted in the given way.
+Contents::Contents(const string &sort)
+{
+	if(sort == "none")
+		return;
+	
+	isSorted = true;
+	byTitle = false;
+	for(size_t start = 0; start < sort.length(); )
+	{
+		size_t end = min(sort.find(',', start), sort.length());
+		string key = sort.substr(start, end - start);
+		start = end + 1;
+		
+		byTitle |= (key == "title");
+		byFirstLine |= (key == "first-line");
+		byAuthor |= (key == "author");
+	}
+}
+
+
+
+// Add an entry for the given song, which starts on the given page.
+void Contents::Add(const Song &song, const Page &firstPage)
+{
+	Add(song.Title(), song.Subtitle(), isSorted && byFirstLine ? FirstLine(song) : "",
+		isSorted && byAuthor ? Author(song) : "", firstPage);
+}
+
+
+
+// Add an entry for the song with the given title, subtitle, first line and
+// authors, which starts on the given page.
+void Contents::Add(const string &title, const string &subtitle, const string &firstLine, const string &author, const Page &firstPage)
+{
+	string destination = Destination(firstPage, title);
+	if(byTitle)
+		AddEntry(TextType::INDEX, title + " (" + subtitle + ")", firstPage, destination);
+	// A song that starts with its title only needs to be listed once.
+	if(byFirstLine && !firstLine.empty() && !Unicode::SameText(firstLine.substr(0, title.length()), title))
+		AddEntry(TextType::INDEX, firstLine, firstPage, destination);
+	// A song may have several authors, separated by commas.
+	for(size_t start = 0; byAuthor && start < author.length(); )
+	{
+		size_t end = min(author.find(',', start), author.length());
+		size_t first = author.find_first_not_of(' ', start);
+		size_t last = author.find_last_not_of(' ', end - 1);
+		if(first < end && last != string::npos && last >= first)
+			AddEntry(TextType::INDEX, author.substr(first, last + 1 - first) + ": " + title, firstPage, destination);
+		start = end + 1;
+	}
+}
+
+
+
+// Add a heading for the section that starts on the given page. Headings are
+// only listed if the index is in the same order as the book.
+void Contents::AddSection(const string &section, const Page &firstPage)
+{
+	if(section.empty())
+		return;
+	
+	string destination = Destination(firstPage, section);
+	if(!isSorted)
+		AddEntry(TextType::TITLE, section, firstPage, destination);
+}
+
+
+
+// Lay out the index on as many pages as it needs.
+vector<Page> Contents::Layout() const
+{
+	// Sorting only compares the keys, which were computed in advance.
+	vector<const Entry *> order;
+	for(const Entry &entry : entries)
+		order.push_back(&entry);
+	if(isSorted)
+		stable_sort(order.begin(), order.end(), [](const Entry *a, const Entry *b)
+		{
+			return a->key < b->key;
+		});
+	
+	vector<Page> pages(1);
+	for(const Entry *entry : order)
+	{
+		// Try twice to add the line. If it fails the first time, that means
+		// we need to start a new page.
+		for(int tries = 0; tries < 2; ++tries)
+		{
+			if(pages.back().AddLine(entry->type, entry->text, entry->number, entry->destination))
+				break;
+			pages.emplace_back();
+		}
+	}
+	return pages;
+}
+
+
+
+// Get the first line of a song's lyrics.
+string Contents::FirstLine(const Song &song)
+{
+	for(const Line &line : song)
+		if(line.Has(TextType::TEXT))
+		{
+			// Join the text of all the blocks, collapsing the whitespace.
+			string text;
+			for(const Block &block : line)
+				for(char c : block.Get(TextType::TEXT))
+				{
+					bool isSpace = (c >= 0 && c <= ' ');
+					if(!isSpace)
+						text += c;
+					else if(!text.empty() && text.back() != ' ')
+						text += ' ';
+				}
+			while(!text.empty() && text.back() == ' ')
+				text.pop_back();
+			// Leave off any punctuation at the end of the line.
+			while(!text.empty() && (text.back() == ',' || text.back() == ';' || text.back() == ':'))
+				text.pop_back();
+			return text;
+		}
+	return "";
+}
+
+
+
+// Get the authors of a song.
+string Contents::Author(const Song &song)
+{
+	const string &author = song.Metadata("author");
+	return author.empty() ? song.Subtitle() : author;
+}
+
+
+
+// Add an entry with the given text, sorted by that text.
+void Contents::AddEntry(TextType type, const string &text, const Page &firstPage, const string &destination)
+{
+	string number = firstPage.Number();
+	if(firstPage.Volume())
+		number = to_string(firstPage.Volume()) + ":" + number;
+	entries.push_back({isSorted ? CollationKey(text) : "", type, text, number, destination});
+}
+
+
+
+// Get the destination of the next bookmark with the given title on the given
+// page. The songs and sections are added in the same order as their bookmarks,
+// so if two of them on one page have the same title, each gets its own.
+string Contents::Destination(const Page &page, const string &title)
+{
+	int &count = bookmarks[page.Destination(title)];
+	return page.Destination(title, ++count);
+}
+
+
+
+namespace {
+	// Get the key that sorts the given text according to the locale. Comparing
+	// two keys byte by byte gives the same result as strcoll() on the text,
+	// but is much faster, and the key only needs to be made once.
+	string CollationKey(const string &text)
+	{
+		size_t length = strxfrm(nullptr, text.c_str(), 0);
+		string key(length + 1, '\0');
+		strxfrm(&key[0], text.c_str(), length + 1);
+		key.resize(length);
+		return key;
+	}
+}
@@ -0,0 +1,95 @@
+/* Contents.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef CONTENTS_H_
+#define CONTENTS_H_
+
+#include "Page.h"
+#include "Song.h"
+#include "TextType.h"
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+
+// The index (table of contents) of a book. It may list the songs in the order they
+// were added, under their section headings, or it may be sorted by title, by
+// the first line of the lyrics, and by author, with each song listed once for
+// each of those keys. Sorting follows the collation rules of the locale (the
+// LC_COLLATE setting), and each entry's sort key is computed once, when the
+// entry is added, so even a very large index is quick to sort.
+class Contents {
+public:
+	// Create an index, sorted in the given way: "none" (in the order the songs
+	// were added), or a comma-separated list of "title", "first-line", and
+	// "author". Section headings are only listed if the index is not sorted.
+	explicit Contents(const string &sort = "none");
+	
+	// Add an entry for the given song or section, which starts on the given
+	// page. The page is not kept; only its number and the destination of the
+	// song's bookmark are.
+	void Add(const Song &song, const Page &firstPage);
+	void Add(const string &title, const string &subtitle, const string &firstLine, const string &author, const Page &firstPage);
+	void AddSection(const string &section, const Page &firstPage);
+	
+	// Lay out the index on as many pages as it needs, with the current page
+	// settings. The pages are not numbered.
+	vector<Page> Layout() const;
+	
+	// Get the first line of a song's lyrics, and its authors (from its
+	// "author" metadata, or else its subtitle), which the index can be
+	// sorted by.
+	static string FirstLine(const Song &song);
+	static string Author(const Song &song);
+	
+	
+private:
+	// Add an entry with the given text, sorted by that text, which links to
+	// the given destination.
+	void AddEntry(TextType type, const string &text, const Page &firstPage, const string &destination);
+	// Get the destination of the next bookmark with the given title on the
+	// given page.
+	string Destination(const Page &page, const string &title);
+	
+	
+private:
+	class Entry {
+	public:
+		// The collation key, which sorts the same as the text.
+		string key;
+		TextType type;
+		string text;
+		// The page number, with the volume if there is more than one.
+		string number;
+		// Where a link from this entry should go.
+		string destination;
+	};
+	
+	
+private:
+	bool isSorted = false;
+	bool byTitle = true;
+	bool byFirstLine = false;
+	bool byAuthor = false;
+	vector<Entry> entries;
+	// How many bookmarks with each destination name have been linked to.
+	map<string, int> bookmarks;
+};
+
+
+
+#endif
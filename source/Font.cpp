@@ -12,7 +12,12 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Font.h"
 
-#include <fontconfig/fontconfig.h>
+#include "StringTable.h"
+#include "Unicode.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
 
 using namespace std;
 
@@ -20,6 +25,14 @@ using namespace std;
 namespace {
 	// Function for ignoring any writes to the embedded context.
 	Cairo::ErrorStatus Ignore(const unsigned char *, unsigned int) { return CAIRO_STATUS_SUCCESS; }
+	
+	// Font size at which text is measured. Widths scale linearly with the font
+	// size, so they are stored divided by this value.
+	const double REFERENCE_SIZE = 100.;
+	
+	// Check if a character may be drawn with the same face as the one before
+	// it, even if an earlier face in the fallback chain also has it.
+	bool CanJoinRun(uint32_t c);
 }
 
 
@@ -36,9 +49,34 @@ Font::Font(const string &name, double points)
 // Set the font face.
 void Font::SetFace(const string &name)
 {
-	// Get the font face that most closely matches the given string.
+	// Loading a font face is slow, so don't do it if nothing has changed.
+	if(!faces.empty() && name == this->name)
+		return;
+	this->name = name;
+	faces.clear();
+	widths.clear();
+	
+	// Get all the fonts that match the given string, from best to worst,
+	// leaving out any that do not have any characters the better ones lack.
 	FcPattern *pattern = FcNameParse(reinterpret_cast<const unsigned char *>(name.c_str()));
-	face = Cairo::FtFontFace::create(pattern);
+	FcConfigSubstitute(nullptr, pattern, FcMatchPattern);
+	FcDefaultSubstitute(pattern);
+	FcResult result;
+	FcFontSet *fonts = FcFontSort(nullptr, pattern, FcTrue, nullptr, &result);
+	for(int i = 0; fonts && i < fonts->nfont; ++i)
+	{
+		FcPattern *font = FcFontRenderPrepare(nullptr, pattern, fonts->fonts[i]);
+		if(!font)
+			continue;
+		faces.push_back({Cairo::FtFontFace::create(font), GetCoverage(fonts->fonts[i])});
+		FcPatternDestroy(font);
+	}
+	if(fonts)
+		FcFontSetDestroy(fonts);
+	// If nothing matched at all, let cairo pick a face, so that text is at
+	// least measured and drawn the same way.
+	if(faces.empty())
+		faces.push_back({Cairo::FtFontFace::create(pattern), make_shared<Coverage>()});
 	FcPatternDestroy(pattern);
 	
 	// Allocate a PDF context just for measuring the font extents.
@@ -48,10 +86,9 @@ void Font::SetFace(const string &name)
 		// Bail out if allocation failed for some reason.
 		if(!myContext)
 			return;
-		// Set the font size of the context.
-		myContext->set_font_size(size);
+		// All measurements are made at the reference size.
+		myContext->set_font_size(REFERENCE_SIZE);
 	}
-	myContext->set_font_face(face);
 }
 
 
@@ -59,14 +96,9 @@ void Font::SetFace(const string &name)
 // Set the font size.
 void Font::SetSize(double points)
 {
-	// Do nothing if this is already what the size is set to.
-	if(points == size)
-		return;
-	
+	// The measuring context always uses the reference size, so there is no
+	// need to update it or to throw out any cached widths.
 	size = points;
-	// Update the font size in the local context.
-	if(myContext)
-		myContext->set_font_size(size);
 }
 
 
@@ -90,13 +122,40 @@ void Font::SetLineHeight(double points)
 
 // Get the width of the given text string (in points).
 double Font::Width(const string &text) const
+{
+	return Width(StringTable::Intern(text));
+}
+
+
+
+// Get the width of the string with the given ID in the StringTable.
+double Font::Width(uint32_t id) const
 {
 	if(!myContext)
 		return 0;
 	
-	Cairo::TextExtents extents;
-	myContext->get_text_extents(text, extents);
-	return extents.x_advance;
+	// Only ask cairo to measure text that has not been seen before.
+	unique_lock<mutex> lock(widthLock);
+	if(id >= widths.size())
+		widths.resize(StringTable::Size(), -1.);
+	if(widths[id] < 0.)
+	{
+		// Measure each run of text in the face it will be drawn with.
+		const string &text = StringTable::Get(id);
+		double width = 0.;
+		for(size_t pos = 0; pos < text.length(); )
+		{
+			size_t start = pos;
+			const Face &face = NextRun(text, pos);
+			myContext->set_font_face(face.face);
+			
+			Cairo::TextExtents extents;
+			myContext->get_text_extents(pos - start == text.length() ? text : text.substr(start, pos - start), extents);
+			width += extents.x_advance;
+		}
+		widths[id] = width / REFERENCE_SIZE;
+	}
+	return widths[id] * size;
 }
 
 
@@ -117,18 +176,148 @@ double Font::Baseline() const
 
 
 
-// Draw the given text at the given location.
-void Font::Draw(const string &text, Cairo::RefPtr<Cairo::Context> &context, double x, double y) const
+// Get the name of the font face, and its size.
+const string &Font::Name() const
+{
+	return name;
+}
+
+
+
+double Font::Size() const
 {
-	// If this font face is not selected in the given context, select it. This
+	return size;
+}
+
+
+
+// Draw the given text at the given location, optionally scaled to a different
+// size than this font's own size.
+void Font::Draw(const string &text, Cairo::RefPtr<Cairo::Context> &context, double x, double y, double scale) const
+{
+	// Each run of text is drawn right where the one before it ended. If the
+	// face for a run is not selected in the given context, select it. This
 	// check is because there might be a performance penalty to setting a font
-	// face over and over again.
-	if(context->get_font_face() != face)
+	// face over and over again. The size must always be set, because the same
+	// face may be drawn at more than one scale.
+	// Go through the C interface for this, because copying the font's RefPtr
+	// is not thread safe and pages may be drawn on more than one thread.
+	cairo_t *cr = context->cobj();
+	context->move_to(x, y + baseline * scale);
+	for(size_t pos = 0; pos < text.length(); )
 	{
-		context->set_font_face(face);
-		context->set_font_size(size);
+		size_t start = pos;
+		const Face &face = NextRun(text, pos);
+		if(cairo_get_font_face(cr) != face.face->cobj())
+			cairo_set_font_face(cr, face.face->cobj());
+		cairo_set_font_size(cr, size * scale);
+		
+		cairo_show_text(cr, (pos - start == text.length() ? text : text.substr(start, pos - start)).c_str());
 	}
+}
+
+
+
+// Find the run of characters starting at the given position that are all
+// drawn with the same face. Each character is drawn with the first face in the
+// fallback chain that has it, or with the first face if none of them do.
+const Font::Face &Font::NextRun(const string &text, size_t &pos) const
+{
+	const Face *run = nullptr;
+	while(pos < text.length())
+	{
+		size_t length = 0;
+		uint32_t c = Unicode::Decode(text, pos, length);
+		size_t next = pos + length;
+		// Spaces and accents are drawn in the same face as the characters
+		// around them, if it has them.
+		if(run && CanJoinRun(c) && run->coverage->Has(c))
+		{
+			pos = next;
+			continue;
+		}
+		
+		const Face *face = &faces.front();
+		for(const Face &it : faces)
+			if(it.coverage->Has(c))
+			{
+				face = &it;
+				break;
+			}
+		if(run && face != run)
+			break;
+		run = face;
+		pos = next;
+	}
+	return run ? *run : faces.front();
+}
+
+
+
+// Get the coverage of the given font. The coverage of every font that has been
+// loaded is kept, so each font is only looked up once, no matter how many Fonts
+// or fallback chains use it.
+shared_ptr<const Font::Coverage> Font::GetCoverage(FcPattern *font)
+{
+	static map<pair<string, int>, shared_ptr<const Coverage>> cache;
+	static mutex cacheMutex;
 	
-	context->move_to(x, y + baseline);
-	context->show_text(text);
+	FcChar8 *file = nullptr;
+	int index = 0;
+	FcPatternGetString(font, FC_FILE, 0, &file);
+	FcPatternGetInteger(font, FC_INDEX, 0, &index);
+	pair<string, int> key(file ? reinterpret_cast<const char *>(file) : "", index);
+	unique_lock<mutex> lock(cacheMutex);
+	if(file)
+	{
+		auto it = cache.find(key);
+		if(it != cache.end())
+			return it->second;
+	}
+	
+	// Fontconfig stores the character set in blocks of 256 characters. Copy
+	// the blocks into a plain array, where they can be looked up quickly.
+	shared_ptr<Coverage> coverage = make_shared<Coverage>();
+	FcCharSet *charSet = nullptr;
+	if(FcPatternGetCharSet(font, FC_CHARSET, 0, &charSet) == FcResultMatch)
+	{
+		FcChar32 map[FC_CHARSET_MAP_SIZE];
+		FcChar32 next;
+		for(FcChar32 base = FcCharSetFirstPage(charSet, map, &next); base != FC_CHARSET_DONE;
+				base = FcCharSetNextPage(charSet, map, &next))
+		{
+			coverage->blocks.push_back(base >> 8);
+			coverage->bits.emplace_back();
+			copy(map, map + FC_CHARSET_MAP_SIZE, coverage->bits.back().begin());
+		}
+	}
+	if(file)
+		cache[key] = coverage;
+	return coverage;
+}
+
+
+
+// Check if the font has a glyph for the given character.
+bool Font::Coverage::Has(uint32_t c) const
+{
+	uint32_t block = c >> 8;
+	// Most text is in the first block, which always comes first if it is here.
+	size_t i = 0;
+	if(block && !blocks.empty())
+		i = lower_bound(blocks.begin(), blocks.end(), block) - blocks.begin();
+	if(i == blocks.size() || blocks[i] != block)
+		return false;
+	return (bits[i][(c >> 5) & 7] >> (c & 31)) & 1;
+}
+
+
+
+namespace {
+	// Check if a character may be drawn with the same face as the one before
+	// it: spaces, and combining accents.
+	bool CanJoinRun(uint32_t c)
+	{
+		return c == ' ' || c == 0xA0 || (c >= 0x300 && c < 0x370);
+	}
 }
@@ -16,14 +16,24 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <cairomm/context.h>
 #include <cairomm/fontface.h>
 
+#include <fontconfig/fontconfig.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 using namespace std;
 
 
 
 // This class represents a particular weight, style, and size of a particular
-// typeface. It can be used to draw text to a cairo context.
+// typeface. It can be used to draw text to a cairo context. Any characters that
+// the typeface does not have are drawn with a fallback font that does have
+// them, and they are measured with that same font.
 class Font {
 public:
 	Font() = default;
@@ -32,7 +42,12 @@ public:
 	Font(const Font &) = delete;
 	Font &operator=(const Font &) = delete;
 	
-	// Set the font face and font size.
+	// Set the font face and font size. Setting the face to the one that is
+	// already loaded does nothing, and changing the size is cheap because text
+	// widths are measured once at a reference size and then scaled. The name
+	// may list several families in order of preference, separated by commas
+	// (such as "Ubuntu,Noto Sans CJK JP:style=Regular"). Fontconfig adds the
+	// closest system fonts after them, to cover any characters they lack.
 	void SetFace(const string &name);
 	void SetSize(double points);
 	// Set how far below the draw coordinates the "baseline" of the text should
@@ -41,19 +56,61 @@ public:
 	// Set the total height of a line of text drawn with this font.
 	void SetLineHeight(double points);
 	
-	// Get the width of the given text string (in points).
+	// Get the width of the given text string (in points), or of the string
+	// with the given ID in the StringTable. This may be called from more
+	// than one thread at once.
 	double Width(const string &text) const;
+	double Width(uint32_t id) const;
 	// Get the suggested height of a line of text in this font (in points).
 	double LineHeight() const;
 	// Get the baseline height.
 	double Baseline() const;
+	// Get the name of the font face, and its size.
+	const string &Name() const;
+	double Size() const;
+	
+	// Draw the given text at the given location, optionally scaled to a
+	// different size than this font's own size.
+	void Draw(const string &text, Cairo::RefPtr<Cairo::Context> &context, double x, double y, double scale = 1.) const;
+	
+	
+private:
+	// The characters a font has glyphs for, as a bitmap. Only the blocks of
+	// 256 characters that the font has any glyphs in are stored.
+	class Coverage {
+	public:
+		// Check if the font has a glyph for the given character.
+		bool Has(uint32_t c) const;
+		
+		// The index of each block (the character divided by 256), in order.
+		vector<uint32_t> blocks;
+		// The bits for each block, one per character.
+		vector<array<uint32_t, 8>> bits;
+	};
+	
+	// One of the faces in the fallback chain.
+	class Face {
+	public:
+		Cairo::RefPtr<Cairo::FtFontFace> face;
+		shared_ptr<const Coverage> coverage;
+	};
 	
-	// Draw the given text at the given location.
-	void Draw(const string &text, Cairo::RefPtr<Cairo::Context> &context, double x, double y) const;
+	
+private:
+	// Find the run of characters starting at the given position that are all
+	// drawn with the same face. Returns that face, and moves the position to
+	// the end of the run.
+	const Face &NextRun(const string &text, size_t &pos) const;
+	// Get the coverage of the given font, which is only looked up the first
+	// time any Font uses it.
+	static shared_ptr<const Coverage> GetCoverage(FcPattern *font);
 	
 	
 private:
-	Cairo::RefPtr<Cairo::FtFontFace> face;
+	string name;
+	// The faces to draw text with, in order of preference. The first one is
+	// the face that best matches the name.
+	vector<Face> faces;
 	double size = 12.;
 	double baseline = 9.;
 	double lineHeight = 14.;
@@ -61,6 +118,14 @@ private:
 	// Each font stores its own private context so it can make measurements
 	// without having to change the font binding of the main context.
 	Cairo::RefPtr<Cairo::Context> myContext;
+	// Cache of the width of each string that has been measured, in units of
+	// the font size, indexed by StringTable ID. A negative value means that
+	// string has not been measured yet. This only needs to be cleared if the
+	// face changes.
+	mutable vector<double> widths;
+	// The cache and the measuring context are shared by every thread that
+	// measures text with this font.
+	mutable mutex widthLock;
 };
 
 
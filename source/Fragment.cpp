@@ -12,21 +12,39 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Fragment.h"
 
+#include "StringTable.h"
+
 using namespace std;
 
 
 
 // Constructor.
-Fragment::Fragment(const Font &font, const string &text, double x, double y)
-	: font(&font), text(text), x(x), y(y)
+Fragment::Fragment(const Font &font, const string &text, double x, double y, double scale)
+	: Fragment(font, StringTable::Intern(text), x, y, scale)
+{
+}
+
+
+
+// Construct a fragment from the ID of its text in the StringTable.
+Fragment::Fragment(const Font &font, uint32_t text, double x, double y, double scale)
+	: font(&font), text(text), x(x), y(y), scale(scale), width(font.Width(text) * scale)
+{
+}
+
+
+
+// Construct a fragment whose width is already known.
+Fragment::Fragment(const Font &font, const string &text, double x, double y, double scale, double width)
+	: font(&font), text(StringTable::Intern(text)), x(x), y(y), scale(scale), width(width)
 {
 }
 
 
 
-void Fragment::Draw(Cairo::RefPtr<Cairo::Context> &context, double xOff, double yOff) const
+void Fragment::Draw(Renderer &renderer, double xOff, double yOff) const
 {
 	if(font)
-		font->Draw(text, context, x + xOff, y + yOff);
+		renderer.DrawText(*font, StringTable::Get(text), x + xOff, y + yOff, scale, width);
 }
 
@@ -14,9 +14,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #define FRAGMENT_H_
 
 #include "Font.h"
+#include "Renderer.h"
 
-#include <cairomm/context.h>
-
+#include <cstdint>
 #include <string>
 
 using namespace std;
@@ -26,16 +26,25 @@ using namespace std;
 // Class representing a single text fragment and its position on the page.
 class Fragment {
 public:
-	Fragment(const Font &font, const string &text, double x, double y);
+	Fragment(const Font &font, const string &text, double x, double y, double scale = 1.);
+	// Construct a fragment from the ID of its text in the StringTable.
+	Fragment(const Font &font, uint32_t text, double x, double y, double scale = 1.);
+	// Construct a fragment whose width is already known, such as one that is
+	// read back from a page recording, without measuring it again.
+	Fragment(const Font &font, const string &text, double x, double y, double scale, double width);
 	
-	void Draw(Cairo::RefPtr<Cairo::Context> &context, double xOff = 0., double yOff = 0.) const;
+	void Draw(Renderer &renderer, double xOff = 0., double yOff = 0.) const;
 	
 	
 private:
 	const Font *font = nullptr;
-	string text;
+	uint32_t text;
 	double x;
 	double y;
+	double scale;
+	// The width of the text, measured when it was laid out, so that drawing
+	// never needs to measure anything.
+	double width;
 	
 	friend class Page;
 };
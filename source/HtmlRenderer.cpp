@@ -0,0 +1,191 @@
+/* HtmlRenderer.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+
+#include "HtmlRenderer.h"
+
+#include "Unicode.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+namespace {
+	// Get the CSS properties that select the font with the given fontconfig
+	// name, such as "Ubuntu:style=Medium Italic".
+	string FontStyle(const string &name);
+	// Escape the characters that have a special meaning in HTML.
+	string Escape(const string &text);
+}
+
+
+
+// Write a web page with sheets of the given size to the given path.
+HtmlRenderer::HtmlRenderer(const string &path, double width, double height)
+	: out(path), width(width), height(height)
+{
+	out << "<!DOCTYPE html>\n"
+		<< "<html>\n"
+		<< "<head>\n"
+		<< "<meta charset=\"utf-8\">\n"
+		<< "<style>\n"
+		<< "svg { display: block; margin: 1em auto; background: white; box-shadow: 0 0 .3em gray; }\n"
+		<< "text { white-space: pre; }\n"
+		<< ".leader { stroke: black; stroke-width: 1; stroke-dasharray: 1 7; }\n"
+		<< "</style>\n"
+		<< "</head>\n"
+		<< "<body>\n";
+}
+
+
+
+// Finish the last sheet and the page.
+HtmlRenderer::~HtmlRenderer()
+{
+	if(isOpen)
+		out << "</svg>\n";
+	out << "</body>\n"
+		<< "</html>\n";
+}
+
+
+
+void HtmlRenderer::DrawText(const Font &font, const string &text, double x, double y, double scale, double width)
+{
+	BeginSheet();
+	const string &name = Class(font);
+	out << "<text class=\"" << name << "\" x=\"" << x << "\" y=\"" << y + font.Baseline() * scale
+		<< "\" font-size=\"" << font.Size() * scale << "\" textLength=\"" << width
+		<< "\" lengthAdjust=\"spacingAndGlyphs\">" << Escape(text) << "</text>\n";
+}
+
+
+
+void HtmlRenderer::DrawLeader(double fromX, double toX, double y)
+{
+	BeginSheet();
+	out << "<line class=\"leader\" x1=\"" << fromX << "\" y1=\"" << y
+		<< "\" x2=\"" << toX << "\" y2=\"" << y << "\"/>\n";
+}
+
+
+
+void HtmlRenderer::EndSheet()
+{
+	// A sheet with nothing on it is still a sheet.
+	BeginSheet();
+	out << "</svg>\n";
+	isOpen = false;
+}
+
+
+
+// Start a new sheet, unless one has already been started.
+void HtmlRenderer::BeginSheet()
+{
+	if(isOpen)
+		return;
+	
+	out << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width << "pt\" height=\"" << height
+		<< "pt\" viewBox=\"0 0 " << width << ' ' << height << "\">\n";
+	isOpen = true;
+}
+
+
+
+// Get the CSS class for the given font, defining its style the first time it
+// is used. A style element in an SVG image applies to the whole page.
+const string &HtmlRenderer::Class(const Font &font)
+{
+	auto it = classes.find(font.Name());
+	if(it != classes.end())
+		return it->second;
+	
+	string name = "f" + to_string(classes.size());
+	out << "<style>." << name << " { " << FontStyle(font.Name()) << " }</style>\n";
+	return classes.emplace(font.Name(), name).first->second;
+}
+
+
+
+namespace {
+	// Get the CSS properties that select the font with the given fontconfig
+	// name. The families come before the first colon, and the weight and
+	// slant are picked out of whatever comes after it.
+	string FontStyle(const string &name)
+	{
+		size_t colon = name.find(':');
+		// There may be several families, which the browser falls back on in
+		// the same order.
+		string family;
+		for(size_t start = 0; start < min(colon, name.length()); )
+		{
+			size_t end = min(name.find(',', start), min(colon, name.length()));
+			family += (family.empty() ? "\"" : ", \"") + name.substr(start, end - start) + "\"";
+			start = end + 1;
+		}
+		string style;
+		if(colon != string::npos)
+			for(size_t i = colon + 1; i < name.length(); ++i)
+				style += Unicode::LowerCase(name[i]);
+		
+		// Check the longer names first, because "semibold" contains "bold".
+		static const pair<const char *, int> WEIGHTS[] = {
+			{"thin", 100},
+			{"extralight", 200},
+			{"ultralight", 200},
+			{"semibold", 600},
+			{"demibold", 600},
+			{"extrabold", 800},
+			{"ultrabold", 800},
+			{"light", 300},
+			{"medium", 500},
+			{"bold", 700},
+			{"black", 900},
+			{"heavy", 900}
+		};
+		int weight = 400;
+		for(const auto &it : WEIGHTS)
+			if(style.find(it.first) != string::npos)
+			{
+				weight = it.second;
+				break;
+			}
+		bool isItalic = (style.find("italic") != string::npos || style.find("oblique") != string::npos);
+		
+		return "font-family: " + family + "; font-weight: " + to_string(weight)
+			+ "; font-style: " + (isItalic ? "italic" : "normal") + ";";
+	}
+	
+	
+	
+	// Escape the characters that have a special meaning in HTML.
+	string Escape(const string &text)
+	{
+		string result;
+		for(char c : text)
+		{
+			if(c == '&')
+				result += "&amp;";
+			else if(c == '<')
+				result += "&lt;";
+			else if(c == '>')
+				result += "&gt;";
+			else if(c == '"')
+				result += "&quot;";
+			else
+				result += c;
+		}
+		return result;
+	}
+}
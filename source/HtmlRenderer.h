@@ -0,0 +1,64 @@
+/* HtmlRenderer.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+
+#ifndef HTML_RENDERER_H_
+#define HTML_RENDERER_H_
+
+#include "Renderer.h"
+
+#include <fstream>
+#include <map>
+#include <string>
+
+using namespace std;
+
+
+
+// Renderer that writes a web page, with each sheet as an SVG image holding the
+// text at exactly the positions it was laid out at. Fonts are referred to by
+// name in CSS, so the browser draws the text with its own copy of each font:
+// nothing is rasterized and no fonts are embedded. Each piece of text is
+// stretched to the width it was measured at, so the layout stays the same
+// even if the browser's version of a font is slightly different.
+class HtmlRenderer : public Renderer {
+public:
+	// Write a web page with sheets of the given size to the given path.
+	HtmlRenderer(const string &path, double width, double height);
+	// Finish the last sheet and the page.
+	virtual ~HtmlRenderer() override;
+	
+	virtual void DrawText(const Font &font, const string &text, double x, double y, double scale, double width) override;
+	virtual void DrawLeader(double fromX, double toX, double y) override;
+	virtual void EndSheet() override;
+	
+	
+private:
+	// Start a new sheet, unless one has already been started.
+	void BeginSheet();
+	// Get the CSS class for the given font. The first time each font is used,
+	// its style is defined in the current sheet.
+	const string &Class(const Font &font);
+	
+	
+private:
+	ofstream out;
+	double width;
+	double height;
+	bool isOpen = false;
+	// The CSS class for each font face that has been used, by its name.
+	map<string, string> classes;
+};
+
+
+
+#endif
@@ -23,13 +23,7 @@ Leader::Leader(double fromX, double toX, double y)
 
 
 
-void Leader::Draw(Cairo::RefPtr<Cairo::Context> &context, double xOff, double yOff) const
+void Leader::Draw(Renderer &renderer, double xOff, double yOff) const
 {
-	vector<double> pattern = {1., 7.};
-	context->set_dash(pattern, 0.);
-	context->set_line_width(1);
-	
-	context->move_to(fromX + xOff, y + yOff);
-	context->line_to(toX + xOff, y + yOff);
-	context->stroke();
+	renderer.DrawLeader(fromX + xOff, toX + xOff, y + yOff);
 }
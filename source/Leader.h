@@ -13,7 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef LEADER_H_
 #define LEADER_H_
 
-#include <cairomm/context.h>
+#include "Renderer.h"
 
 using namespace std;
 
@@ -24,13 +24,15 @@ class Leader {
 public:
 	Leader(double fromX, double toX, double y);
 	
-	void Draw(Cairo::RefPtr<Cairo::Context> &context, double xOff = 0., double yOff = 0.) const;
+	void Draw(Renderer &renderer, double xOff = 0., double yOff = 0.) const;
 	
 	
 private:
 	double fromX;
 	double toX;
 	double y;
+	
+	friend class Page;
 };
 
 
@@ -12,38 +12,58 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Line.h"
 
+#include "Unicode.h"
+
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 namespace {
 	bool NextToken(const string &line, size_t &pos, string &token, TextType &type);
+	// Find the first occurrence of either of the given characters, at or after
+	// the given position. Returns the length of the text if there is none.
+	size_t Find(const string &text, size_t pos, char first, char second);
 }
 
 
 
-Line::Line(const string &line)
+Line::Line(const string &line, bool indent)
 {
-	Parse(line);
+	Parse(line, indent);
 }
 
 
 
 // Parse a line of text. The caller is responsible for screening out comment
 // lines and not handing them to this function.
-void Line::Parse(const string &line)
+void Line::Parse(const string &line, bool indent)
 {
-	// Find the first non-whitespace character in this line.
+	// Find the first non-whitespace character in this line. A line that is
+	// indented with no-break spaces, for example, is still indented.
 	size_t pos = 0;
-	// TODO: Handle UTF-8 characters like curly quotes.
-	while(pos < line.length() && line[pos] <= ' ' && line[pos] >= 0)
-		++pos;
+	while(size_t length = Unicode::SpaceLength(line, pos))
+		pos += length;
 	// If this is an empty line, bail out.
 	if(pos == line.length())
 		return;
 	// Otherwise, check if it is indented.
-	isIndented = (pos != 0);
+	isIndented = (pos != 0 || indent);
 	
+	// Collect the tokens for each line of the current block, so that a run
+	// of several chords is added to the block all at once.
 	string token;
 	TextType type;
+	vector<string> tokens[3];
+	auto addTokens = [this, &tokens](TextType type)
+	{
+		if(!tokens[type].empty())
+			back().Add(tokens[type], type);
+		tokens[type].clear();
+	};
 	while(NextToken(line, pos, token, type))
 	{
 		// First of all, if there are no blocks in the line yet, add one to
@@ -51,12 +71,23 @@ void Line::Parse(const string &line)
 		// subtext and that line of the current block is already filled in.
 		// TODO: Fix the logic here. Should only chords start a new block?
 		// Would that allow subtext to be placed after text instead of before? (Do I want that?)
+		if(!empty() && type != TextType::TEXT)
+		{
+			addTokens(TextType::TEXT);
+			addTokens(TextType::SUBTEXT);
+		}
 		if(empty() || (type != TextType::TEXT && (back().Has(TextType::TEXT) || back().Has(TextType::SUBTEXT))))
+		{
+			if(!empty())
+				addTokens(TextType::CHORD);
 			emplace_back();
+		}
 		
 		// Add this token to the appropriate line of the current block.
-		back().Add(token, type);
+		tokens[type].push_back(token);
 	}
+	for(size_t i = 0; i < 3; ++i)
+		addTokens(static_cast<TextType>(i));
 	
 	// Check what types of text this line contains.
 	for(const Block &block : *this)
@@ -82,6 +113,84 @@ bool Line::Has(TextType type) const
 
 
 
+// Get the words in the given type of text, converted to lower case and without
+// punctuation. Curly apostrophes are dropped just like straight ones, and
+// curly quotes and Unicode spaces end a word.
+void Line::Words(TextType type, vector<string> &words) const
+{
+	words.clear();
+	if(!has[type])
+		return;
+	
+	string word;
+	for(size_t i = 0; i <= size(); ++i)
+	{
+		// Treat the end of the line as a space, to finish the last word.
+		const string &text = (i < size() ? (*this)[i].Get(type) : string(" "));
+		for(size_t pos = 0, length = 1; pos < text.length(); pos += length)
+		{
+			char c = text[pos];
+			length = 1;
+			if(c & 0x80)
+			{
+				uint32_t code = Unicode::Decode(text, pos, length);
+				bool isApostrophe = (code == 0x2018 || code == 0x2019);
+				bool isQuote = (code >= 0x201A && code <= 0x201F) || code == 0xAB || code == 0xBB;
+				// Anything else that is not ASCII is assumed to be part of a word.
+				if(!isApostrophe && !isQuote && !Unicode::IsSpace(code))
+					word.append(text, pos, length);
+				else if(!isApostrophe && !word.empty())
+				{
+					words.push_back(word);
+					word.clear();
+				}
+			}
+			else if((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+				word += c;
+			else if(c >= 'A' && c <= 'Z')
+				word += c + ('a' - 'A');
+			else if(c != '\'' && !word.empty())
+			{
+				words.push_back(word);
+				word.clear();
+			}
+		}
+	}
+}
+
+
+
+// Get a hash of this line's text and indentation. This is not stored, because
+// transposing the chords changes it.
+size_t Line::Hash() const
+{
+	// This is the 64-bit FNV-1a hash of the block IDs and indent flags.
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](uint64_t value)
+	{
+		hash ^= value;
+		hash *= 1099511628211ull;
+	};
+	mix(isIndented);
+	for(const Block &block : *this)
+		for(size_t i = 0; i < 3; ++i)
+		{
+			TextType type = static_cast<TextType>(i);
+			mix(block.Id(type) * 2 + block.IsIndented(type));
+		}
+	return static_cast<size_t>(hash);
+}
+
+
+
+// Check if two lines have the same text and indentation.
+bool Line::operator==(const Line &other) const
+{
+	return isIndented == other.isIndented && static_cast<const vector<Block> &>(*this) == other;
+}
+
+
+
 namespace {
 	bool NextToken(const string &line, size_t &pos, string &token, TextType &type)
 	{
@@ -93,10 +202,8 @@ namespace {
 		size_t start = pos + (type != TextType::TEXT);
 		// If this is a text block, search for the start of the next thing other
 		// than a text block. Otherwise, search for the closing character.
-		const char *END[] = {"]", "[{", "}"};
-		pos = line.find_first_of(END[type], start);
-		if(pos == string::npos)
-			pos = line.length();
+		static const char END[][2] = {{']', ']'}, {'[', '{'}, {'}', '}'}};
+		pos = Find(line, start, END[type][0], END[type][1]);
 		// Set the token to the block of text we just found.
 		token.assign(line, start, pos - start);
 		// If we're at a closing character, move forward one character.
@@ -105,4 +212,30 @@ namespace {
 		
 		return true;
 	}
+	
+	
+	// Find the first occurrence of either of the given characters. They are
+	// both ASCII, and every byte of a multi-byte UTF-8 character has its high
+	// bit set, so a plain byte search can never find one inside a character.
+	// Where SSE2 is available, this checks 16 bytes at a time.
+	size_t Find(const string &text, size_t pos, char first, char second)
+	{
+		const char *data = text.data();
+		size_t end = text.length();
+#ifdef __SSE2__
+		const __m128i firstMask = _mm_set1_epi8(first);
+		const __m128i secondMask = _mm_set1_epi8(second);
+		for( ; pos + 16 <= end; pos += 16)
+		{
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+			int found = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, firstMask), _mm_cmpeq_epi8(chunk, secondMask)));
+			if(found)
+				return pos + __builtin_ctz(found);
+		}
+#endif
+		for( ; pos < end; ++pos)
+			if(data[pos] == first || data[pos] == second)
+				return pos;
+		return end;
+	}
 }
@@ -16,6 +16,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Block.h"
 #include "TextType.h"
 
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -26,16 +27,26 @@ using namespace std;
 class Line : public vector<Block> {
 public:
 	Line() = default;
-	explicit Line(const string &line);
+	explicit Line(const string &line, bool indent = false);
 	
 	// Parse a line of text. The caller is responsible for screening out comment
-	// lines and not handing them to this function.
-	void Parse(const string &line);
+	// lines and not handing them to this function. If the indent flag is set,
+	// the line is indented even if it does not start with whitespace.
+	void Parse(const string &line, bool indent = false);
 	
 	// Check if this line is indented.
 	bool IsIndented() const;
 	// Check what types of text this line contains.
 	bool Has(TextType type) const;
+	// Get the words in the given type of text, converted to lower case and
+	// without punctuation. Apostrophes are dropped, so "don't" and "dont" are
+	// the same word. Chords in the middle of a word do not split it.
+	void Words(TextType type, vector<string> &words) const;
+	
+	// Get a hash of this line's text and indentation, and check if two lines
+	// have the same text and indentation (so their layouts will be the same).
+	size_t Hash() const;
+	bool operator==(const Line &other) const;
 	
 	
 private:
@@ -0,0 +1,107 @@
+/* Manifest.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Manifest.h"
+
+#include <glob.h>
+
+using namespace std;
+
+namespace {
+	// Trim leading and trailing whitespace from the given line.
+	string Trim(const string &line);
+}
+
+
+
+// Constructor, specifying the path to the manifest file.
+Manifest::Manifest(const string &path)
+	: in(path)
+{
+	size_t slash = path.rfind('/');
+	if(slash != string::npos)
+		directory = path.substr(0, slash + 1);
+	catalogPath = directory + "songs.catalog";
+}
+
+
+
+// Get the path to the next song file, and the name of the section that it
+// starts (if any).
+bool Manifest::Next(string &path, string &section)
+{
+	section.clear();
+	string line;
+	while(next == matches.size())
+	{
+		if(!getline(in, line))
+			return false;
+		
+		line = Trim(line);
+		if(line.empty() || line[0] == '#')
+			continue;
+		if(line.front() == '[' && line.back() == ']')
+		{
+			section = Trim(line.substr(1, line.length() - 2));
+			continue;
+		}
+		if(!line.compare(0, 8, "catalog:"))
+		{
+			catalogPath = Trim(line.substr(8));
+			if(catalogPath[0] != '/')
+				catalogPath = directory + catalogPath;
+			catalog.reset();
+			continue;
+		}
+		if(line[0] == '?')
+		{
+			if(!catalog)
+				catalog.reset(new Catalog(catalogPath));
+			matches = catalog->Find(line.substr(1));
+			next = 0;
+			continue;
+		}
+		
+		// Relative paths are relative to the manifest, not the working folder.
+		if(line[0] != '/')
+			line = directory + line;
+		
+		// Expand the pattern into a sorted list of files. A pattern that does
+		// not match any files is skipped.
+		matches.clear();
+		next = 0;
+		glob_t result;
+		if(!glob(line.c_str(), 0, nullptr, &result))
+			for(size_t i = 0; i < result.gl_pathc; ++i)
+				matches.emplace_back(result.gl_pathv[i]);
+		globfree(&result);
+	}
+	path = matches[next++];
+	return true;
+}
+
+
+
+namespace {
+	// Trim leading and trailing whitespace from the given line. Bytes of UTF-8
+	// characters are negative, and must not be mistaken for whitespace.
+	string Trim(const string &line)
+	{
+		size_t start = 0;
+		while(start < line.length() && line[start] <= ' ' && line[start] >= 0)
+			++start;
+		size_t end = line.length();
+		while(end > start && line[end - 1] <= ' ' && line[end - 1] >= 0)
+			--end;
+		return line.substr(start, end - start);
+	}
+}
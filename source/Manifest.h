@@ -0,0 +1,61 @@
+/* Manifest.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MANIFEST_H_
+#define MANIFEST_H_
+
+#include "Catalog.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+
+// A manifest lists the songs in a book, in order. Each line is the path to a
+// song file or a glob pattern, relative to the manifest's own directory. A
+// line of the form "[Section name]" starts a new section, and empty lines and
+// lines starting with '#' are ignored. The manifest is read one line at a time
+// as the songs are needed, so a long list is never all in memory at once.
+// A line starting with '?' is a query, which adds all the matching songs from
+// a catalog (see Catalog.h). The catalog is "songs.catalog" in the manifest's
+// directory, unless a "catalog: <path>" line says otherwise.
+class Manifest {
+public:
+	explicit Manifest(const string &path);
+	
+	// Get the path to the next song file. If a new section begins with this
+	// song, its name is returned as well; otherwise the section is cleared.
+	// This returns false once there are no more songs.
+	bool Next(string &path, string &section);
+	
+	
+private:
+	ifstream in;
+	string directory;
+	
+	// The catalog is only opened once it is needed.
+	string catalogPath;
+	unique_ptr<Catalog> catalog;
+	
+	// Files that the most recent glob pattern matched and that have not been
+	// returned yet.
+	vector<string> matches;
+	size_t next = 0;
+};
+
+
+
+#endif
@@ -0,0 +1,228 @@
+/* MinHash.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MinHash.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+	// The number of words in each shingle.
+	const size_t SHINGLE_WORDS = 3;
+	// The signature is split into this many bands for locality-sensitive
+	// hashing. With 16 bands of 8 values, a pair of songs with 70% of their
+	// shingles in common is found about half the time, and one with 85% in
+	// common almost always.
+	const size_t BANDS = 16;
+	const size_t ROWS = MinHash::SIZE / BANDS;
+	// Songs in a bucket bigger than this (usually because they are exact
+	// copies) are only compared to the first song in the bucket.
+	const size_t MAX_BUCKET = 64;
+	
+	// Mix the bits of the given number, so that every bit of the output depends
+	// on every bit of the input. This is the "splitmix64" finalizer.
+	uint64_t Mix(uint64_t value);
+	
+	// The coefficients of each of the signature's hash functions.
+	class HashFunctions {
+	public:
+		HashFunctions();
+		
+		uint64_t multiply[MinHash::SIZE];
+		uint64_t add[MinHash::SIZE];
+	};
+	// Hash the given text, continuing from the given hash (64-bit FNV-1a).
+	uint64_t Hash(const string &text, uint64_t hash = 14695981039346656037ull);
+	// Find the root of the given song's group, compressing the path to it.
+	size_t Find(vector<size_t> &parent, size_t song);
+}
+
+
+
+// Construct a signature of the given song's lyrics.
+MinHash::MinHash(const Song &song)
+{
+	// Collect all the words, ignoring line breaks.
+	vector<string> words;
+	vector<string> lineWords;
+	for(const Line &line : song)
+	{
+		line.Words(TextType::TEXT, lineWords);
+		words.insert(words.end(), lineWords.begin(), lineWords.end());
+	}
+	if(words.empty())
+		return;
+	
+	// Hash each shingle. Repeated lines (e.g. a chorus) repeat their shingles,
+	// and those only need to be counted once.
+	vector<uint64_t> shingles;
+	size_t count = (words.size() > SHINGLE_WORDS ? words.size() - SHINGLE_WORDS + 1 : 1);
+	for(size_t i = 0; i < count; ++i)
+	{
+		uint64_t hash = Hash(words[i]);
+		for(size_t j = i + 1; j < i + SHINGLE_WORDS && j < words.size(); ++j)
+			hash = Hash(words[j], Hash(" ", hash));
+		shingles.push_back(hash);
+	}
+	sort(shingles.begin(), shingles.end());
+	shingles.erase(unique(shingles.begin(), shingles.end()), shingles.end());
+	
+	// Each hash function is a different multiply-add of the shingle's hash,
+	// keeping the high 32 bits. That is cheap enough for the inner loop to be
+	// vectorized, which matters because it runs SIZE times per shingle.
+	static const HashFunctions FUNCTIONS;
+	fill(values, values + SIZE, numeric_limits<uint32_t>::max());
+	for(uint64_t shingle : shingles)
+		for(size_t i = 0; i < SIZE; ++i)
+			values[i] = min(values[i], static_cast<uint32_t>((shingle * FUNCTIONS.multiply[i] + FUNCTIONS.add[i]) >> 32));
+	isEmpty = false;
+}
+
+
+
+// Check if the song had no lyrics to compare.
+bool MinHash::IsEmpty() const
+{
+	return isEmpty;
+}
+
+
+
+// Estimate the fraction of shingles that the two songs have in common.
+double MinHash::Similarity(const MinHash &other) const
+{
+	if(isEmpty || other.isEmpty)
+		return 0.;
+	
+	size_t same = 0;
+	for(size_t i = 0; i < SIZE; ++i)
+		same += (values[i] == other.values[i]);
+	return same / static_cast<double>(SIZE);
+}
+
+
+
+// Find groups of songs that are near duplicates.
+vector<vector<size_t>> MinHash::Cluster(const vector<MinHash> &songs, double threshold)
+{
+	// Each song starts out in its own group. Whenever two songs are found to be
+	// similar, their groups are merged.
+	vector<size_t> parent(songs.size());
+	for(size_t i = 0; i < songs.size(); ++i)
+		parent[i] = i;
+	mutex parentLock;
+	
+	{
+		ThreadPool pool;
+		for(size_t band = 0; band < BANDS; ++band)
+			pool.Add([&songs, &parent, &parentLock, threshold, band]()
+			{
+				// Put the songs in buckets by the hash of this band's values.
+				unordered_map<uint64_t, vector<size_t>> buckets;
+				for(size_t i = 0; i < songs.size(); ++i)
+					if(!songs[i].isEmpty)
+					{
+						const uint32_t *values = songs[i].values + band * ROWS;
+						uint64_t hash = 14695981039346656037ull;
+						for(size_t j = 0; j < ROWS; ++j)
+							hash = Mix(hash ^ values[j]);
+						buckets[hash].push_back(i);
+					}
+			
+				// Check which songs that share a bucket are really similar.
+				vector<pair<size_t, size_t>> similar;
+				for(const pair<const uint64_t, vector<size_t>> &it : buckets)
+				{
+					const vector<size_t> &bucket = it.second;
+					for(size_t a = 0; a < bucket.size() && (!a || bucket.size() <= MAX_BUCKET); ++a)
+						for(size_t b = a + 1; b < bucket.size(); ++b)
+							if(songs[bucket[a]].Similarity(songs[bucket[b]]) >= threshold)
+								similar.emplace_back(bucket[a], bucket[b]);
+				}
+			
+				lock_guard<mutex> guard(parentLock);
+				for(const pair<size_t, size_t> &it : similar)
+					parent[Find(parent, it.second)] = Find(parent, it.first);
+			});
+	}
+	
+	// Gather up the groups that have more than one song in them.
+	unordered_map<size_t, vector<size_t>> groups;
+	for(size_t i = 0; i < songs.size(); ++i)
+		groups[Find(parent, i)].push_back(i);
+	vector<vector<size_t>> clusters;
+	for(pair<const size_t, vector<size_t>> &it : groups)
+		if(it.second.size() > 1)
+			clusters.push_back(move(it.second));
+	sort(clusters.begin(), clusters.end());
+	return clusters;
+}
+
+
+
+namespace {
+	// Pick the coefficients of each hash function. The multipliers must be odd.
+	HashFunctions::HashFunctions()
+	{
+		for(size_t i = 0; i < MinHash::SIZE; ++i)
+		{
+			multiply[i] = Mix(2 * i + 1) | 1;
+			add[i] = Mix(2 * i + 2);
+		}
+	}
+	
+	
+	
+	// Mix the bits of the given number.
+	uint64_t Mix(uint64_t value)
+	{
+		value ^= value >> 30;
+		value *= 0xBF58476D1CE4E5B9ull;
+		value ^= value >> 27;
+		value *= 0x94D049BB133111EBull;
+		value ^= value >> 31;
+		return value;
+	}
+	
+	
+	
+	// Hash the given text, continuing from the given hash.
+	uint64_t Hash(const string &text, uint64_t hash)
+	{
+		for(char c : text)
+		{
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+	
+	
+	
+	// Find the root of the given song's group, compressing the path to it.
+	size_t Find(vector<size_t> &parent, size_t song)
+	{
+		while(parent[song] != song)
+		{
+			parent[song] = parent[parent[song]];
+			song = parent[song];
+		}
+		return song;
+	}
+}
@@ -0,0 +1,64 @@
+/* MinHash.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MIN_HASH_H_
+#define MIN_HASH_H_
+
+#include "Song.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+
+
+// A MinHash signature of the lyrics of a song, for finding songs that are near
+// copies of each other, such as different arrangements or transcriptions. The
+// lyrics are split into "shingles" of three words in a row, ignoring chords,
+// punctuation, and case. Each value in the signature is the smallest hash of
+// any shingle under a different hash function, so the fraction of values that
+// two signatures share is an estimate of the fraction of their shingles that
+// the two songs have in common.
+class MinHash {
+public:
+	// The number of values in each signature.
+	static const size_t SIZE = 128;
+	
+	
+public:
+	MinHash() = default;
+	explicit MinHash(const Song &song);
+	
+	// Check if the song had no lyrics to compare.
+	bool IsEmpty() const;
+	// Estimate the fraction of shingles that the two songs have in common.
+	double Similarity(const MinHash &other) const;
+	
+	// Find groups of songs that are near duplicates, i.e. each one's similarity
+	// to some other song in the group is at least the given threshold. The
+	// signature is divided into bands, and only songs that match in at least
+	// one band are compared ("locality-sensitive hashing"), so this is much
+	// faster than comparing every pair. Each band is checked in parallel. The
+	// groups are sorted, and each one lists the songs' indices in order.
+	static vector<vector<size_t>> Cluster(const vector<MinHash> &songs, double threshold);
+	
+	
+private:
+	uint32_t values[SIZE];
+	bool isEmpty = true;
+};
+
+
+
+#endif
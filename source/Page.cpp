@@ -12,7 +12,13 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Page.h"
 
+#include "Binary.h"
 #include "Font.h"
+#include "StringTable.h"
+
+#include <cmath>
+#include <deque>
+#include <unordered_map>
 
 using namespace std;
 
@@ -33,6 +39,53 @@ namespace {
 	double titleGap;
 	
 	Font font[7];
+	
+	// The text of the songs themselves may be scaled to a different size than
+	// the configuration specifies, for songs that override the text size.
+	double textSize;
+	double scale = 1.;
+	
+	// Get the scale factor that applies to the given type of text. Page
+	// numbers and index entries are never scaled.
+	double Scale(TextType type);
+	// Cache of the layout of every line that has been added all at once. Each
+	// line starts at the left margin (plus the indent, if any), so its layout
+	// only depends on its contents and on the current text scale. The keys
+	// point to copies of the lines, which are stored separately.
+	class LineKey {
+	public:
+		const Line *line;
+		double scale;
+	};
+	class LineHash {
+	public:
+		size_t operator()(const LineKey &key) const { return key.line->Hash() ^ hash<double>()(key.scale); }
+	};
+	class LineEqual {
+	public:
+		bool operator()(const LineKey &a, const LineKey &b) const { return a.scale == b.scale && *a.line == *b.line; }
+	};
+	class LineLayout {
+	public:
+		// The fragments, with y positions relative to the top of the line.
+		vector<Fragment> fragments;
+		// Where the last row of the line starts, and where it ends.
+		double lastRow;
+		double endX;
+		// The height of each row of the line.
+		double rowHeight;
+	};
+	unordered_map<LineKey, LineLayout, LineHash, LineEqual> lineCache;
+	deque<Line> cachedLines;
+	// The cache only holds lines at the current text scale, and at most this
+	// many of them, so that it stays small no matter how many songs are laid
+	// out or how many sizes are tried while fitting them.
+	const size_t LINE_CACHE_SIZE = 4096;
+	
+	// Get the scaled width of a string or height of a line of the given type.
+	double TextWidth(TextType type, const string &text);
+	double TextWidth(TextType type, uint32_t id);
+	double TextHeight(TextType type);
 }
 
 
@@ -40,19 +93,27 @@ namespace {
 // Initialize all the page output settings based on the given configuration.
 void Page::Init(Config &config)
 {
-	// Set the page layout values.
-	width = config.Value("page-width", "8.5 in");
-	height = config.Value("page-height", "11 in");
+	// Set the page layout values. Slides are shown on a 16:9 screen, so they
+	// have their own default size and margins.
+	bool isSlides = (config.Text("layout", "single") == "slides");
+	width = config.Value("page-width", isSlides ? "13.333 in" : "8.5 in");
+	height = config.Value("page-height", isSlides ? "7.5 in" : "11 in");
 	
-	leftMargin = config.Value("margin-left", "1 in");
-	topMargin = config.Value("margin-top", "1 in");
-	rightMargin = width - config.Value("margin-right", "1 in");
-	bottomMargin = height - config.Value("margin-bottom", "1 in");
+	string margin = isSlides ? "0.5 in" : "1 in";
+	leftMargin = config.Value("margin-left", margin);
+	topMargin = config.Value("margin-top", margin);
+	rightMargin = width - config.Value("margin-right", margin);
+	bottomMargin = height - config.Value("margin-bottom", margin);
 	
 	indent = config.Value("line-indent", "0.5 in");
 	outdent = config.Value("block-indent", "0.2 in");
 	
-	double textSize = config.Value("text-size", 12);
+	textSize = config.Value("text-size", 12);
+	scale = 1.;
+	
+	// Any cached line layouts depend on the old settings.
+	lineCache.clear();
+	cachedLines.clear();
 	lineGap = config.Value("line-gap", textSize * .25);
 	stanzaGap = config.Value("stanza-gap", textSize * 1.5);
 	titleGap = config.Value("title-gap", stanzaGap);
@@ -98,6 +159,30 @@ void Page::Init(Config &config)
 
 
 
+// Change the size of the song text, scaling all the other song fonts and gaps
+// by the same amount. A size of zero restores the configured size.
+void Page::SetTextSize(double points)
+{
+	double newScale = (points > 0. && textSize > 0.) ? points / textSize : 1.;
+	// Line layouts at any other scale are not likely to be needed again.
+	if(newScale != scale)
+	{
+		lineCache.clear();
+		cachedLines.clear();
+	}
+	scale = newScale;
+}
+
+
+
+// Get the size that song text is currently being laid out at.
+double Page::TextSize()
+{
+	return textSize * scale;
+}
+
+
+
 // Get the page width.
 double Page::Width()
 {
@@ -114,6 +199,14 @@ double Page::Height()
 
 
 
+// Get the height available for text on each page, between the margins.
+double Page::Usable()
+{
+	return bottomMargin - topMargin;
+}
+
+
+
 // Construct a page, with the given page number.
 Page::Page(size_t number)
 	: x(leftMargin), y(topMargin)
@@ -148,9 +241,9 @@ bool Page::Add(const Line &line, const Block &block, bool force)
 	{
 		TextType type = static_cast<TextType>(i);
 		if(block.Has(type))
-			width = max(width, font[type].Width(block.Get(type)) + outdent * block.IsIndented(type));
+			width = max(width, TextWidth(type, block.Id(type)) + outdent * block.IsIndented(type));
 		if(line.Has(type))
-			lineHeight += font[type].LineHeight();
+			lineHeight += TextHeight(type);
 	}
 	
 	// If this block will not fit on the page, start a new page.
@@ -184,10 +277,10 @@ bool Page::Add(const Line &line, const Block &block, bool force)
 		if(block.Has(type))
 		{
 			double textX = x + outdent * block.IsIndented(type);
-			emplace_back(font[type], block.Get(type), textX, textY);
+			emplace_back(font[type], block.Id(type), textX, textY, Scale(type));
 		}
 		if(line.Has(type))
-			textY += font[type].LineHeight();
+			textY += TextHeight(type);
 	}
 	// Advance the x position.
 	x += width;
@@ -197,32 +290,97 @@ bool Page::Add(const Line &line, const Block &block, bool force)
 
 
 
+// Try to add a whole line of text to this page, wrapping it if necessary. If
+// the line does not fit, nothing is added and this returns false.
+bool Page::Add(const Line &line)
+{
+	// If this line has been laid out before, just move the old layout down to
+	// the current position.
+	auto it = lineCache.find(LineKey{&line, scale});
+	if(it != lineCache.end())
+	{
+		const LineLayout &layout = it->second;
+		if(!layout.fragments.empty() && y + layout.lastRow + layout.rowHeight > bottomMargin)
+			return false;
+		
+		for(const Fragment &fragment : layout.fragments)
+		{
+			push_back(fragment);
+			back().y += y;
+		}
+		y += layout.lastRow;
+		x = layout.endX;
+		return true;
+	}
+	
+	// Otherwise, lay out the line one block at a time. If the line does not
+	// fit on this page, undo everything that was added.
+	size_t first = size();
+	double startY = y;
+	Indent(line.IsIndented());
+	for(const Block &block : line)
+		if(!Add(line, block))
+		{
+			erase(begin() + first, end());
+			y = startY;
+			x = leftMargin;
+			return false;
+		}
+	
+	// Remember this layout, in case this same line appears again.
+	LineLayout layout;
+	layout.fragments.assign(begin() + first, end());
+	for(Fragment &fragment : layout.fragments)
+		fragment.y -= startY;
+	layout.lastRow = y - startY;
+	layout.endX = x;
+	layout.rowHeight = 0.;
+	for(size_t i = 0; i < 3; ++i)
+		if(line.Has(static_cast<TextType>(i)))
+			layout.rowHeight += TextHeight(static_cast<TextType>(i));
+	
+	if(lineCache.size() >= LINE_CACHE_SIZE)
+	{
+		lineCache.clear();
+		cachedLines.clear();
+	}
+	cachedLines.push_back(line);
+	lineCache.emplace(LineKey{&cachedLines.back(), scale}, move(layout));
+	
+	return true;
+}
+
+
+
 // Try to add a line of the given type of text. If two strings are given,
 // the second one is placed right-aligned. This returns false if there is
 // not space for this line on this page.
-bool Page::AddLine(TextType type, const string &left, const string &right)
+bool Page::AddLine(TextType type, const string &left, const string &right, const string &destination)
 {
 	// Check if there's space for this line on this page. If not, return false.
-	if(y + font[type].LineHeight() > bottomMargin)
+	if(y + TextHeight(type) > bottomMargin)
 		return false;
+	if(!destination.empty())
+		links.push_back({leftMargin, y, rightMargin - leftMargin, TextHeight(type), destination});
 	
 	// Place the text.
+	double baseline = font[type].Baseline() * Scale(type);
 	if(!left.empty())
-		emplace_back(font[type], left, x, y);
+		emplace_back(font[type], left, x, y, Scale(type));
 	if(!right.empty())
 	{
 		// Position the leader line.
-		double leftWidth = font[type].Width(left);
-		double rightWidth = font[type].Width(right);
-		double fromX = leftMargin + leftWidth + font[type].Baseline();
-		double toX = rightMargin - rightWidth - font[type].Baseline();
-		double lineY = y + font[type].Baseline();
+		double leftWidth = TextWidth(type, left);
+		double rightWidth = TextWidth(type, right);
+		double fromX = leftMargin + leftWidth + baseline;
+		double toX = rightMargin - rightWidth - baseline;
+		double lineY = y + baseline;
 		leaders.emplace_back(fromX, toX, lineY);
 		
-		emplace_back(font[type], right, rightMargin - rightWidth, y);
+		emplace_back(font[type], right, rightMargin - rightWidth, y, Scale(type));
 	}
 	// Advance to the next line.
-	y += font[type].LineHeight();
+	y += TextHeight(type);
 	
 	return true;
 }
@@ -237,10 +395,10 @@ void Page::EndLine(const Line &line)
 	{
 		TextType type = static_cast<TextType>(i);
 		if(line.Has(type))
-			y += font[type].LineHeight();
+			y += TextHeight(type);
 	}
 	// Add the gap, depending on whether this line was empty or not.
-	y += (line.empty() ? stanzaGap : lineGap);
+	y += (line.empty() ? stanzaGap : lineGap) * scale;
 	// Reset the x position to the start of the line.
 	x = leftMargin;
 }
@@ -250,12 +408,31 @@ void Page::EndLine(const Line &line)
 // End the title block (i.e. add the title gap).
 void Page::EndTitle()
 {
-	y += titleGap;
+	y += titleGap * scale;
 	x = leftMargin;
 }
 
 
 
+// Get how much of the usable height of this page has been filled.
+double Page::Used() const
+{
+	return y - topMargin;
+}
+
+
+
+// Check if any of the text on this page runs past the right margin.
+bool Page::Overflows() const
+{
+	for(const Fragment &fragment : *this)
+		if(fragment.x + fragment.width > rightMargin)
+			return true;
+	return false;
+}
+
+
+
 // Get the page number string.
 const string &Page::Number() const
 {
@@ -264,13 +441,21 @@ const string &Page::Number() const
 
 
 
+// Change the page number. Zero means the page is not numbered.
+void Page::SetNumber(size_t number)
+{
+	pageNumber = number ? to_string(number) : string();
+}
+
+
+
 // Set the alignment of the page number: -1 = left, 0 = center, 1 = right.
 void Page::PlaceNumber(int side)
 {
 	if(pageNumber.empty())
 		return;
 	
-	double numberWidth = font[TextType::NUMBER].Width(pageNumber);
+	double numberWidth = TextWidth(TextType::NUMBER, pageNumber);
 	emplace_back(
 		font[TextType::NUMBER],
 		pageNumber,
@@ -278,8 +463,252 @@ void Page::PlaceNumber(int side)
 		bottomMargin);
 }
 
+
+
+// Get which volume this page is in, or zero if there is only one.
+size_t Page::Volume() const
+{
+	return volume;
+}
+
+
+
+// Set which volume this page is in.
+void Page::SetVolume(size_t volume)
+{
+	this->volume = volume;
+}
+
 // Get the leader lines, if any.
 const vector<Leader> &Page::Leaders() const
 {
 	return leaders;
 }
+
+
+
+// Mark the current position as the start of a song, or the top of the page as
+// the start of a section. Keep the bookmarks in order from top to bottom, with
+// a section before the first song in it.
+void Page::AddBookmark(const string &title, int level)
+{
+	Bookmark bookmark{title, level, level ? y : topMargin};
+	auto it = bookmarks.end();
+	while(it != bookmarks.begin() && ((it - 1)->y > bookmark.y || ((it - 1)->y == bookmark.y && (it - 1)->level > level)))
+		--it;
+	bookmarks.insert(it, bookmark);
+}
+
+
+
+// Get the bookmarks on this page, from top to bottom.
+const vector<Page::Bookmark> &Page::Bookmarks() const
+{
+	return bookmarks;
+}
+
+
+
+// Get the areas of this page that link to bookmarks on other pages.
+const vector<Page::Link> &Page::Links() const
+{
+	return links;
+}
+
+
+
+// Get the name of the link destination for the given bookmark on this page.
+string Page::Destination(size_t bookmark) const
+{
+	if(bookmark >= bookmarks.size())
+		return "";
+	
+	const string &title = bookmarks[bookmark].title;
+	int nth = 1;
+	for(size_t i = 0; i < bookmark; ++i)
+		nth += (bookmarks[i].title == title);
+	string name = pageNumber.empty() ? title : title + " @" + pageNumber;
+	return nth == 1 ? name : name + " #" + to_string(nth);
+}
+
+
+
+// Get the name of the link destination for the nth bookmark with the given
+// title on this page.
+string Page::Destination(const string &title, int nth) const
+{
+	for(size_t i = 0; i < bookmarks.size(); ++i)
+		if(bookmarks[i].title == title && !--nth)
+			return Destination(i);
+	return "";
+}
+
+
+
+// Get a hash of everything that is drawn on this page. String IDs depend on
+// the order the strings were first seen in, so the text itself is hashed, and
+// positions are rounded to a hundredth of a point.
+uint64_t Page::Hash() const
+{
+	// This is the 64-bit FNV-1a hash.
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](const void *data, size_t size)
+	{
+		for(size_t i = 0; i < size; ++i)
+		{
+			hash ^= static_cast<const unsigned char *>(data)[i];
+			hash *= 1099511628211ull;
+		}
+	};
+	auto mixNumber = [&mix](double value)
+	{
+		long long rounded = llround(value * 100.);
+		mix(&rounded, sizeof(rounded));
+	};
+	auto mixString = [&mix](const string &text)
+	{
+		mix(text.c_str(), text.length() + 1);
+	};
+	
+	for(const Fragment &fragment : *this)
+	{
+		mixString(fragment.font->Name());
+		mixNumber(fragment.font->Size() * fragment.scale);
+		mixString(StringTable::Get(fragment.text));
+		mixNumber(fragment.x);
+		mixNumber(fragment.y);
+	}
+	for(const Leader &leader : leaders)
+	{
+		mixNumber(leader.fromX);
+		mixNumber(leader.toX);
+		mixNumber(leader.y);
+	}
+	return hash;
+}
+
+
+
+// Write everything that is drawn on this page, except for its number, to the
+// given stream. Each fragment's font is stored as the type of text it is for,
+// along with the width it was measured at, so loading it needs no fonts.
+void Page::Save(ostream &out) const
+{
+	Binary::Write(out, static_cast<uint32_t>(size()));
+	for(const Fragment &fragment : *this)
+	{
+		uint8_t type = 0;
+		while(type < TextType::INDEX && fragment.font != &font[type])
+			++type;
+		Binary::Write(out, type);
+		Binary::Write(out, StringTable::Get(fragment.text));
+		Binary::Write(out, fragment.x);
+		Binary::Write(out, fragment.y);
+		Binary::Write(out, fragment.scale);
+		Binary::Write(out, fragment.width);
+	}
+	Binary::Write(out, static_cast<uint32_t>(leaders.size()));
+	for(const Leader &leader : leaders)
+	{
+		Binary::Write(out, leader.fromX);
+		Binary::Write(out, leader.toX);
+		Binary::Write(out, leader.y);
+	}
+	Binary::Write(out, static_cast<uint32_t>(bookmarks.size()));
+	for(const Bookmark &bookmark : bookmarks)
+	{
+		Binary::Write(out, bookmark.title);
+		Binary::Write(out, static_cast<int32_t>(bookmark.level));
+		Binary::Write(out, bookmark.y);
+	}
+}
+
+
+
+// Read back a page that was written by Save(), replacing whatever is on this
+// page now except for its number.
+bool Page::Load(istream &in)
+{
+	clear();
+	leaders.clear();
+	bookmarks.clear();
+	links.clear();
+	
+	// Each count is checked against what is left of the file before making
+	// room for that many items, in case the file is damaged.
+	uint32_t count = 0;
+	if(!Binary::Read(in, count) || !Binary::HasBytes(in, count))
+		return false;
+	reserve(count);
+	string text;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		uint8_t type;
+		double x;
+		double y;
+		double scale;
+		double width;
+		if(!Binary::Read(in, type) || !Binary::Read(in, text) || !Binary::Read(in, x) || !Binary::Read(in, y)
+				|| !Binary::Read(in, scale) || !Binary::Read(in, width) || type > TextType::INDEX)
+			return false;
+		emplace_back(font[type], text, x, y, scale, width);
+	}
+	
+	if(!Binary::Read(in, count))
+		return false;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		double fromX;
+		double toX;
+		double y;
+		if(!Binary::Read(in, fromX) || !Binary::Read(in, toX) || !Binary::Read(in, y))
+			return false;
+		leaders.emplace_back(fromX, toX, y);
+	}
+	
+	if(!Binary::Read(in, count) || !Binary::HasBytes(in, count))
+		return false;
+	bookmarks.resize(count);
+	for(Bookmark &bookmark : bookmarks)
+	{
+		int32_t level;
+		if(!Binary::Read(in, bookmark.title) || !Binary::Read(in, level) || !Binary::Read(in, bookmark.y))
+			return false;
+		bookmark.level = level;
+	}
+	return true;
+}
+
+
+
+namespace {
+	// Get the scale factor that applies to the given type of text. Page
+	// numbers and index entries are never scaled.
+	double Scale(TextType type)
+	{
+		return (type <= TextType::SUBTITLE ? scale : 1.);
+	}
+	
+	
+	
+	// Get the scaled width of a string of the given type.
+	double TextWidth(TextType type, const string &text)
+	{
+		return font[type].Width(text) * Scale(type);
+	}
+	
+	
+	
+	double TextWidth(TextType type, uint32_t id)
+	{
+		return font[type].Width(id) * Scale(type);
+	}
+	
+	
+	
+	// Get the scaled height of a line of the given type.
+	double TextHeight(TextType type)
+	{
+		return font[type].LineHeight() * Scale(type);
+	}
+}
@@ -20,6 +20,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Line.h"
 #include "TextType.h"
 
+#include <cstdint>
+#include <istream>
+#include <ostream>
 #include <vector>
 
 using namespace std;
@@ -28,18 +31,46 @@ using namespace std;
 
 // Represents a single output page, and the text laid out on it.
 class Page : public vector<Fragment> {
+public:
+	// A place on this page where a song or a section starts, which is listed
+	// in the PDF outline. Sections are at level 0, and songs at level 1.
+	class Bookmark {
+	public:
+		string title;
+		int level;
+		double y;
+	};
+	// An area of this page that links to a bookmark on some other page.
+	class Link {
+	public:
+		double x;
+		double y;
+		double width;
+		double height;
+		string destination;
+	};
+	
+	
 public:
 	// Initialize all the page output settings based on the given configuration.
+	// This may be called again whenever the configuration changes; fonts are
+	// only reloaded if their face has changed.
 	static void Init(Config &config);
+	// Change the size of the song text, scaling all the other song fonts and
+	// gaps by the same amount. A size of zero restores the configured size.
+	static void SetTextSize(double points);
+	static double TextSize();
 	// Get the page dimensions.
 	static double Width();
 	static double Height();
+	// Get the height available for text on each page, between the margins.
+	static double Usable();
 	
 	
 public:
 	// Construct a page, with the given page number.
 	explicit Page(size_t number = 0);
-
+	
 	// Set whether the text is indented. Call this at the start of each line.
 	void Indent(bool isIndented);
 	// Add a line of chords to the page. If there is no 
@@ -48,29 +79,80 @@ public:
 	// The line needs to be passed in because it's possible that a given block
 	// does not have a particular line of text but the line does.
 	bool Add(const Line &line, const Block &block, bool force = false);
+	// Try to add a whole line of text to this page, wrapping it if necessary.
+	// This includes the indent, if any, but not the gap after the line. If
+	// the line does not fit, nothing is added and this returns false. Lines
+	// that have already been laid out once are copied instead of being laid
+	// out again, because many songs repeat the same lines over and over.
+	bool Add(const Line &line);
 	// Try to add a line of the given type of text. If two strings are given,
 	// the second one is placed right-aligned. This returns false if there is
-	// not space for this line on this page.
-	bool AddLine(TextType type, const string &left, const string &right = "");
+	// not space for this line on this page. If a destination is given, the
+	// whole line links to it.
+	bool AddLine(TextType type, const string &left, const string &right = "", const string &destination = "");
 	// End the given line of layout, adding a gap after it.
 	void EndLine(const Line &line);
 	// End the title block (i.e. add the title gap).
 	void EndTitle();
-
-	// Get the page number string.
+	
+	// Get how much of the usable height of this page has been filled.
+	double Used() const;
+	// Check if any of the text on this page runs past the right margin. That
+	// can only happen if a single block or title is wider than the page.
+	bool Overflows() const;
+	
+	// Get the page number string, or change the page number. Zero means the
+	// page is not numbered.
 	const string &Number() const;
+	void SetNumber(size_t number);
 	// Set the alignment of the page number: -1 = left, 0 = center, 1 = right.
 	void PlaceNumber(int side = 0);
+	// Get or set which volume this page is in, if the book is split into
+	// several volumes. Zero means it is not.
+	size_t Volume() const;
+	void SetVolume(size_t volume);
 	
 	// Get the leader lines, if any.
 	const vector<Leader> &Leaders() const;
 	
+	// Mark the current position as the start of a song (level 1), or the top
+	// of the page as the start of a section (level 0). Sections always start
+	// on a new page, but are marked after their first song has been laid out.
+	void AddBookmark(const string &title, int level = 1);
+	// Get the bookmarks on this page, from top to bottom, and the links.
+	const vector<Bookmark> &Bookmarks() const;
+	const vector<Link> &Links() const;
+	// Get the name of the link destination for the given bookmark on this
+	// page, or for the nth bookmark (counting from 1) with the given title.
+	// The name includes the page number, such as "Amazing Grace @12", and if
+	// several bookmarks on one page have the same title, the later ones end in
+	// " #2", " #3", and so on, so every name is unique within a volume. This
+	// returns an empty string if there is no such bookmark.
+	string Destination(size_t bookmark) const;
+	string Destination(const string &title, int nth = 1) const;
+	
+	// Get a hash of everything that is drawn on this page. This is the same
+	// from one run to the next as long as the page looks the same, so it can
+	// be used to find which pages of a book have changed.
+	uint64_t Hash() const;
+	
+	// Write everything that is drawn on this page, except for its number, to
+	// the given stream, or read it back in, along with its bookmarks. The page
+	// must be read back with the same fonts, but it may be given any number.
+	// Links are not saved, because they point to other pages. Reading returns
+	// false if the data is not valid.
+	void Save(ostream &out) const;
+	bool Load(istream &in);
+	
 	
 private:
 	string pageNumber;
+	size_t volume = 0;
 	double x;
 	double y;
 	vector<Leader> leaders;
+	vector<Bookmark> bookmarks;
+	vector<Link> links;
 };
 
 
@@ -0,0 +1,99 @@
+/* Preview.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Preview.h"
+
+#include "CairoRenderer.h"
+
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+
+#include <cmath>
+
+using namespace std;
+
+namespace {
+	// Function for collecting the PNG data in a string.
+	cairo_status_t Append(void *closure, const unsigned char *data, unsigned int length);
+}
+
+
+
+// Create a preview renderer that keeps at most the given number of images.
+Preview::Preview(size_t capacity)
+	: capacity(capacity)
+{
+}
+
+
+
+// Get a PNG image of the given page, at the given resolution.
+string Preview::Render(const Page &page, double dpi)
+{
+	// Page::Hash() only covers what is drawn, so two pages that are different
+	// sizes can have the same hash.
+	Key key{page.Hash(), Page::Width(), Page::Height(), dpi};
+	{
+		unique_lock<mutex> guard(lock);
+		auto it = cache.find(key);
+		if(it != cache.end())
+		{
+			images.splice(images.begin(), images, it->second);
+			return it->second->second;
+		}
+	}
+	
+	// Draw the page on a white background. Don't hold the lock while drawing,
+	// so that other pages can be drawn at the same time. If another thread is
+	// drawing this same page, that just means it gets drawn twice.
+	double scale = dpi / 72.;
+	Cairo::RefPtr<Cairo::ImageSurface> surface = Cairo::ImageSurface::create(Cairo::FORMAT_RGB24,
+		static_cast<int>(ceil(Page::Width() * scale)), static_cast<int>(ceil(Page::Height() * scale)));
+	Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create(surface);
+	context->set_source_rgb(1., 1., 1.);
+	context->paint();
+	context->set_source_rgb(0., 0., 0.);
+	context->scale(scale, scale);
+	CairoRenderer renderer(context);
+	for(const Fragment &fragment : page)
+		fragment.Draw(renderer);
+	for(const Leader &leader : page.Leaders())
+		leader.Draw(renderer);
+	surface->flush();
+	
+	string png;
+	cairo_surface_write_to_png_stream(surface->cobj(), &Append, &png);
+	
+	unique_lock<mutex> guard(lock);
+	if(!cache.count(key))
+	{
+		images.emplace_front(key, png);
+		cache[key] = images.begin();
+		while(images.size() > capacity)
+		{
+			cache.erase(images.back().first);
+			images.pop_back();
+		}
+	}
+	return png;
+}
+
+
+
+namespace {
+	// Function for collecting the PNG data in a string.
+	cairo_status_t Append(void *closure, const unsigned char *data, unsigned int length)
+	{
+		static_cast<string *>(closure)->append(reinterpret_cast<const char *>(data), length);
+		return CAIRO_STATUS_SUCCESS;
+	}
+}
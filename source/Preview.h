@@ -0,0 +1,78 @@
+/* Preview.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef PREVIEW_H_
+#define PREVIEW_H_
+
+#include "Page.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+using namespace std;
+
+
+
+// Draws pages as PNG images, for previews and thumbnails. The images are drawn
+// straight from the laid out pages, without making a PDF first. Any number of
+// pages may be drawn at once on different threads. The most recently used
+// images are kept in a cache, which is identified by each page's Hash(), the
+// page size, and the resolution, so a page that still looks the same after
+// the book has been laid out again is not drawn again.
+class Preview {
+public:
+	// Create a preview renderer that keeps at most the given number of images.
+	explicit Preview(size_t capacity = 256);
+	
+	// Get a PNG image of the given page, at the given resolution in dots per
+	// inch. This may be called from several threads at once.
+	string Render(const Page &page, double dpi);
+	
+	
+private:
+	class Key {
+	public:
+		bool operator==(const Key &other) const
+		{
+			return hash == other.hash && width == other.width && height == other.height && dpi == other.dpi;
+		}
+		
+		uint64_t hash;
+		double width;
+		double height;
+		double dpi;
+	};
+	class KeyHash {
+	public:
+		size_t operator()(const Key &key) const
+		{
+			return key.hash ^ hash<double>()(key.width) ^ (hash<double>()(key.height) << 1) ^ (hash<double>()(key.dpi) << 2);
+		}
+	};
+	
+	
+private:
+	size_t capacity;
+	// The images, with the most recently used one at the front.
+	list<pair<Key, string>> images;
+	unordered_map<Key, list<pair<Key, string>>::iterator, KeyHash> cache;
+	mutex lock;
+};
+
+
+
+#endif
@@ -0,0 +1,205 @@
+/* Recording.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Recording.h"
+
+#include "Binary.h"
+#include "Book.h"
+#include "Contents.h"
+#include "Unicode.h"
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+	const char MAGIC[8] = {'R', 'E', 'C', 'H', 'P', 'A', 'G', '4'};
+	
+	// Get the full path to the given file, so that the same file can be
+	// recognized no matter how the path to it is written.
+	string FullPath(const string &path);
+}
+
+
+
+// Open a recording file, and read the list of songs in it.
+Recording::Recording(const string &path)
+	: in(path, ios::binary)
+{
+	char magic[sizeof(MAGIC)];
+	string text;
+	uint32_t count = 0;
+	if(!in.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC))
+			|| !Binary::Read(in, text) || !Binary::Read(in, count) || !Binary::HasBytes(in, count))
+	{
+		in.close();
+		return;
+	}
+	istringstream settingsIn(text);
+	settings.Load(settingsIn);
+	
+	songs.resize(count);
+	for(Entry &entry : songs)
+		if(!Binary::Read(in, entry.path) || !Binary::Read(in, entry.title) || !Binary::Read(in, entry.subtitle)
+				|| !Binary::Read(in, entry.firstLine) || !Binary::Read(in, entry.author)
+				|| !Binary::Read(in, entry.offset) || !Binary::Read(in, entry.pages))
+		{
+			songs.clear();
+			in.close();
+			return;
+		}
+	start = in.tellg();
+}
+
+
+
+// Lay out the given song with the current page settings, and add it to the
+// recording.
+void Recording::Add(const Song &song, const string &path)
+{
+	vector<Page> pages;
+	Book::Layout(song, pages);
+	Page::SetTextSize(0.);
+	
+	songs.push_back({FullPath(path), song.Title(), song.Subtitle(), Contents::FirstLine(song), Contents::Author(song),
+		data.size(), static_cast<uint32_t>(pages.size())});
+	ostringstream out;
+	for(const Page &page : pages)
+		page.Save(out);
+	data += out.str();
+}
+
+
+
+// Write the recording to the given path, along with the settings that were
+// used to lay out the songs.
+bool Recording::Write(const string &path, const Config &settings) const
+{
+	ofstream out(path, ios::binary);
+	ostringstream settingsOut;
+	settings.Save(settingsOut);
+	
+	out.write(MAGIC, sizeof(MAGIC));
+	Binary::Write(out, settingsOut.str());
+	Binary::Write(out, static_cast<uint32_t>(songs.size()));
+	for(const Entry &entry : songs)
+	{
+		Binary::Write(out, entry.path);
+		Binary::Write(out, entry.title);
+		Binary::Write(out, entry.subtitle);
+		Binary::Write(out, entry.firstLine);
+		Binary::Write(out, entry.author);
+		Binary::Write(out, entry.offset);
+		Binary::Write(out, entry.pages);
+	}
+	out.write(data.data(), data.size());
+	return static_cast<bool>(out);
+}
+
+
+
+// Check if the file was found and is valid.
+bool Recording::IsOpen() const
+{
+	return in.is_open();
+}
+
+
+
+// Get the settings the songs were laid out with.
+const Config &Recording::Settings() const
+{
+	return settings;
+}
+
+
+
+// Find the songs that were read from the given file, or if there are none,
+// the songs with the given title.
+vector<size_t> Recording::Find(const string &name) const
+{
+	vector<size_t> found;
+	string path = FullPath(name);
+	for(size_t i = 0; i < songs.size(); ++i)
+		if(songs[i].path == path)
+			found.push_back(i);
+	
+	for(size_t i = 0; found.empty() && i < songs.size(); ++i)
+		if(Unicode::SameText(songs[i].title, name))
+			found.push_back(i);
+	return found;
+}
+
+
+
+// Get the title of the given song.
+const string &Recording::Title(size_t song) const
+{
+	return songs[song].title;
+}
+
+
+
+// Get the subtitle of the given song.
+const string &Recording::Subtitle(size_t song) const
+{
+	return songs[song].subtitle;
+}
+
+
+
+// Get the first line of the given song.
+const string &Recording::FirstLine(size_t song) const
+{
+	return songs[song].firstLine;
+}
+
+
+
+// Get the authors of the given song.
+const string &Recording::Author(size_t song) const
+{
+	return songs[song].author;
+}
+
+
+
+// Read the pages of the given song, and add them to the end of the given list.
+bool Recording::Read(size_t song, vector<Page> &pages)
+{
+	const Entry &entry = songs[song];
+	in.clear();
+	if(!in.seekg(start + entry.offset))
+		return false;
+	
+	for(uint32_t i = 0; i < entry.pages; ++i)
+	{
+		pages.emplace_back();
+		if(!pages.back().Load(in))
+			return false;
+	}
+	return true;
+}
+
+
+
+namespace {
+	// Get the full path to the given file.
+	string FullPath(const string &path)
+	{
+		char fullPath[PATH_MAX];
+		return realpath(path.c_str(), fullPath) ? fullPath : path;
+	}
+}
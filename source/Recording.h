@@ -0,0 +1,104 @@
+/* Recording.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef RECORDING_H_
+#define RECORDING_H_
+
+#include "Config.h"
+#include "Page.h"
+#include "Song.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+
+// A recording holds the laid out pages of a set of songs, so that any of them
+// can be put together into a book without parsing the songs or measuring any
+// of their text again. The pages are stored without page numbers, so they can
+// be placed anywhere in a book. The file is written by "re-chord compile":
+//
+//   "RECHPAG4"
+//   the settings the songs were laid out with, in the .conf format
+//   the number of songs
+//   for each song: the path it was read from, its title and subtitle, its
+//     first line and authors (for sorted indexes), the offset of its pages,
+//     and how many pages it has
+//   each song's pages, as written by Page::Save()
+//
+// Strings are stored as a 32-bit length followed by the text. Opening a
+// recording only reads the list of songs; each song's pages are read when
+// they are needed.
+class Recording {
+public:
+	// Create an empty recording, to add songs to.
+	Recording() = default;
+	// Open a recording file.
+	explicit Recording(const string &path);
+	
+	// Lay out the given song with the current page settings, and add it to
+	// the recording. The path is the file it was read from.
+	void Add(const Song &song, const string &path);
+	// Write the recording to the given path, along with the settings that
+	// were used to lay out the songs. Returns false if the file can't be
+	// written.
+	bool Write(const string &path, const Config &settings) const;
+	
+	// Check if the file was found and is valid.
+	bool IsOpen() const;
+	// Get the settings the songs were laid out with.
+	const Config &Settings() const;
+	// Find the songs that were read from the given file, or if there are none,
+	// the songs with the given title (ignoring case).
+	vector<size_t> Find(const string &name) const;
+	// Get the title and subtitle of the given song, and the first line and
+	// authors that an index may be sorted by.
+	const string &Title(size_t song) const;
+	const string &Subtitle(size_t song) const;
+	const string &FirstLine(size_t song) const;
+	const string &Author(size_t song) const;
+	// Read the pages of the given song, and add them to the end of the given
+	// list. Returns false if the file is damaged.
+	bool Read(size_t song, vector<Page> &pages);
+	
+	
+private:
+	class Entry {
+	public:
+		string path;
+		string title;
+		string subtitle;
+		string firstLine;
+		string author;
+		uint64_t offset;
+		uint32_t pages;
+	};
+	
+	
+private:
+	Config settings;
+	vector<Entry> songs;
+	// When building a recording, the saved pages of all the songs.
+	string data;
+	// When reading one, the file, and where the pages start in it.
+	ifstream in;
+	uint64_t start = 0;
+};
+
+
+
+#endif
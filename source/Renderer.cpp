@@ -0,0 +1,52 @@
+/* Renderer.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+
+#include "Renderer.h"
+
+#include "CairoRenderer.h"
+#include "HtmlRenderer.h"
+
+using namespace std;
+
+
+
+// Create a renderer that writes to the given path, choosing the format by its
+// extension.
+unique_ptr<Renderer> Renderer::Create(const string &path, double width, double height)
+{
+	size_t dot = path.rfind('.');
+	if(dot != string::npos && path.substr(dot) == ".html")
+		return unique_ptr<Renderer>(new HtmlRenderer(path, width, height));
+	return unique_ptr<Renderer>(new CairoRenderer(path, width, height));
+}
+
+
+
+// Formats without links ignore destinations.
+void Renderer::AddDestination(const string &name, double x, double y)
+{
+}
+
+
+
+// Formats without links ignore them.
+void Renderer::AddLink(double x, double y, double width, double height, const string &destination)
+{
+}
+
+
+
+// Formats without an outline ignore it.
+void Renderer::AddOutline(const string &title, int level, const string &destination)
+{
+}
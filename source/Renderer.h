@@ -0,0 +1,63 @@
+/* Renderer.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+
+#ifndef RENDERER_H_
+#define RENDERER_H_
+
+#include "Font.h"
+
+#include <memory>
+#include <string>
+
+using namespace std;
+
+
+
+// Interface for drawing laid out pages to some kind of output. Each output
+// sheet may hold more than one page side by side, so whatever draws a page
+// gives the offset of that page on the current sheet. Sheets are measured in
+// points, with the origin at the top left.
+class Renderer {
+public:
+	// Create a renderer that writes to the given path, choosing the format by
+	// its extension: ".html" for a web page, and otherwise a PDF. An empty
+	// path means writing a PDF to STDOUT. The sheets are the given size.
+	static unique_ptr<Renderer> Create(const string &path, double width, double height);
+	
+	virtual ~Renderer() = default;
+	
+	// Draw the given text with its top left corner at the given position, in
+	// the given font scaled by the given amount. The width is what the text
+	// measured when it was laid out. Pages may be drawn on several threads at
+	// once, so a renderer must never measure text itself.
+	virtual void DrawText(const Font &font, const string &text, double x, double y, double scale, double width) = 0;
+	// Draw a dotted leader line between the given x positions.
+	virtual void DrawLeader(double fromX, double toX, double y) = 0;
+	// Finish the current sheet, and start a new one.
+	virtual void EndSheet() = 0;
+	
+	// Name the given position on the current sheet, so that links and the
+	// outline can point to it. Formats without links ignore this.
+	virtual void AddDestination(const string &name, double x, double y);
+	// Make the given area of the current sheet a link to the named position,
+	// which may be on a sheet that has not been drawn yet.
+	virtual void AddLink(double x, double y, double width, double height, const string &destination);
+	// Add an entry to the outline of the document, which viewers show as a
+	// clickable table of contents. Entries at level 1 go under the most recent
+	// entry at level 0. The entries must be added in order.
+	virtual void AddOutline(const string &title, int level, const string &destination);
+};
+
+
+
+#endif
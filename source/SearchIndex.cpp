@@ -0,0 +1,289 @@
+/* SearchIndex.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "SearchIndex.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using namespace std;
+
+namespace {
+	// The layout of the file. Text is stored as offsets into the text.
+	const char MAGIC[8] = {'R', 'E', 'C', 'H', 'I', 'D', 'X', '1'};
+	class Header {
+	public:
+		char magic[8];
+		uint32_t songs;
+		uint32_t terms;
+		uint32_t matches;
+		uint32_t text;
+	};
+	class SongRecord {
+	public:
+		uint32_t title;
+		uint32_t page;
+	};
+	class TermRecord {
+	public:
+		uint32_t text;
+		uint32_t first;
+		uint32_t count;
+	};
+	
+	// Add the given string to the text, and return its offset.
+	uint32_t AddText(const string &str, string &text);
+}
+
+
+
+// Open an index file to search it.
+SearchIndex::SearchIndex(const string &path)
+{
+	int file = open(path.c_str(), O_RDONLY);
+	if(file < 0)
+		return;
+	
+	struct stat info;
+	if(!fstat(file, &info) && static_cast<size_t>(info.st_size) >= sizeof(Header))
+	{
+		void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+		if(mapped != MAP_FAILED)
+		{
+			data = static_cast<const char *>(mapped);
+			size = info.st_size;
+		}
+	}
+	close(file);
+	
+	// Make sure this is actually a search index, and that it is not truncated.
+	if(data)
+	{
+		const Header &header = *reinterpret_cast<const Header *>(data);
+		size_t expected = sizeof(Header) + header.songs * sizeof(SongRecord)
+			+ header.terms * sizeof(TermRecord) + header.matches * sizeof(Match) + header.text;
+		if(!equal(begin(MAGIC), end(MAGIC), header.magic) || expected != size)
+		{
+			munmap(const_cast<char *>(data), size);
+			data = nullptr;
+			size = 0;
+		}
+	}
+}
+
+
+
+SearchIndex::~SearchIndex()
+{
+	if(data)
+		munmap(const_cast<char *>(data), size);
+}
+
+
+
+// Start adding the lines of a new song, which starts on the given page.
+void SearchIndex::Add(const Song &song, size_t page)
+{
+	songs.emplace_back(song.Title(), page);
+}
+
+
+
+// Add the words of a line of the current song, which is on the given page.
+void SearchIndex::Add(const Line &line, size_t page)
+{
+	if(songs.empty())
+		return;
+	
+	// Each type of text is indexed separately, so a phrase in the lyrics can't
+	// be split between the lyrics and the subtext.
+	Match match = {static_cast<uint32_t>(songs.size() - 1), static_cast<uint32_t>(page)};
+	vector<string> words;
+	for(TextType type : {TextType::TEXT, TextType::SUBTEXT})
+	{
+		line.Words(type, words);
+		for(size_t i = 0; i < words.size(); ++i)
+		{
+			// Add each word, and each pair of adjacent words. A word usually
+			// occurs many times on the same page, so only add it once.
+			vector<Match> &single = terms[words[i]];
+			if(single.empty() || !(single.back() == match))
+				single.push_back(match);
+			if(i + 1 < words.size())
+			{
+				vector<Match> &adjacent = terms[words[i] + ' ' + words[i + 1]];
+				if(adjacent.empty() || !(adjacent.back() == match))
+					adjacent.push_back(match);
+			}
+		}
+	}
+}
+
+
+
+// Shift the pages that have been added, because the given number of pages
+// were inserted before them.
+void SearchIndex::Shift(size_t pages, size_t from)
+{
+	for(pair<string, uint32_t> &song : songs)
+		if(song.second >= from)
+			song.second += pages;
+	for(pair<const string, vector<Match>> &term : terms)
+		for(Match &match : term.second)
+			if(match.page >= from)
+				match.page += pages;
+}
+
+
+
+// Write out the index.
+bool SearchIndex::Write(const string &path) const
+{
+	// Pages in the file are numbered starting from 1.
+	string text;
+	vector<SongRecord> songRecords;
+	for(const pair<string, uint32_t> &song : songs)
+		songRecords.push_back({AddText(song.first, text), song.second + 1});
+	vector<TermRecord> termRecords;
+	vector<Match> matches;
+	for(const pair<const string, vector<Match>> &term : terms)
+	{
+		termRecords.push_back({AddText(term.first, text), static_cast<uint32_t>(matches.size()),
+			static_cast<uint32_t>(term.second.size())});
+		for(Match match : term.second)
+		{
+			++match.page;
+			matches.push_back(match);
+		}
+	}
+	
+	Header header;
+	copy(begin(MAGIC), end(MAGIC), header.magic);
+	header.songs = songRecords.size();
+	header.terms = termRecords.size();
+	header.matches = matches.size();
+	header.text = text.size();
+	
+	ofstream out(path, ios::binary);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char *>(songRecords.data()), songRecords.size() * sizeof(SongRecord));
+	out.write(reinterpret_cast<const char *>(termRecords.data()), termRecords.size() * sizeof(TermRecord));
+	out.write(reinterpret_cast<const char *>(matches.data()), matches.size() * sizeof(Match));
+	out.write(text.data(), text.size());
+	return static_cast<bool>(out);
+}
+
+
+
+// Find every page that includes all the words of the given text, sorted by
+// song and page.
+vector<SearchIndex::Match> SearchIndex::Find(const string &text) const
+{
+	// Split the text into words the same way the lyrics were.
+	vector<Match> result;
+	vector<string> words;
+	Line(text).Words(TextType::TEXT, words);
+	if(!data || words.empty())
+		return result;
+	
+	// For a phrase, look up each pair of adjacent words instead of each word,
+	// because pairs are much rarer.
+	vector<string> keys;
+	if(words.size() == 1)
+		keys.push_back(words.front());
+	for(size_t i = 0; i + 1 < words.size(); ++i)
+		keys.push_back(words[i] + ' ' + words[i + 1]);
+	
+	// Start with the rarest term, so the intersection is small from the start.
+	vector<pair<const Match *, const Match *>> lists;
+	for(const string &key : keys)
+		lists.push_back(Pages(key));
+	sort(lists.begin(), lists.end(),
+		[](const pair<const Match *, const Match *> &a, const pair<const Match *, const Match *> &b)
+		{
+			return a.second - a.first < b.second - b.first;
+		});
+	
+	result.assign(lists.front().first, lists.front().second);
+	vector<Match> merged;
+	for(size_t i = 1; i < lists.size() && !result.empty(); ++i)
+	{
+		merged.clear();
+		set_intersection(result.begin(), result.end(), lists[i].first, lists[i].second, back_inserter(merged));
+		result.swap(merged);
+	}
+	return result;
+}
+
+
+
+// Get the title of the given song.
+const char *SearchIndex::Title(uint32_t song) const
+{
+	const Header &header = *reinterpret_cast<const Header *>(data);
+	const SongRecord *records = reinterpret_cast<const SongRecord *>(data + sizeof(Header));
+	return (song < header.songs ? data + size - header.text + records[song].title : "");
+}
+
+
+
+// Get the sorted list of pages that have the given term.
+pair<const SearchIndex::Match *, const SearchIndex::Match *> SearchIndex::Pages(const string &term) const
+{
+	const Header &header = *reinterpret_cast<const Header *>(data);
+	const char *records = data + sizeof(Header) + header.songs * sizeof(SongRecord);
+	const TermRecord *termRecords = reinterpret_cast<const TermRecord *>(records);
+	const Match *matches = reinterpret_cast<const Match *>(records + header.terms * sizeof(TermRecord));
+	const char *text = data + size - header.text;
+	
+	// The terms are sorted, so use a binary search.
+	const TermRecord *it = lower_bound(termRecords, termRecords + header.terms, term,
+		[text](const TermRecord &record, const string &key) { return strcmp(text + record.text, key.c_str()) < 0; });
+	if(it == termRecords + header.terms || term != text + it->text)
+		return make_pair(matches, matches);
+	return make_pair(matches + it->first, matches + it->first + it->count);
+}
+
+
+
+// Compare two matches, by song and then by page.
+bool SearchIndex::Match::operator<(const Match &other) const
+{
+	return song < other.song || (song == other.song && page < other.page);
+}
+
+
+
+bool SearchIndex::Match::operator==(const Match &other) const
+{
+	return song == other.song && page == other.page;
+}
+
+
+
+namespace {
+	// Add the given string to the text, and return its offset.
+	uint32_t AddText(const string &str, string &text)
+	{
+		uint32_t offset = text.size();
+		text += str;
+		text += '\0';
+		return offset;
+	}
+}
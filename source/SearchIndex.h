@@ -0,0 +1,102 @@
+/* SearchIndex.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef SEARCH_INDEX_H_
+#define SEARCH_INDEX_H_
+
+#include "Line.h"
+#include "Song.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+
+// An index of every word of the lyrics in a book, and the page or pages of
+// each song that it is on, so that a song can be found by typing part of its
+// lyrics. Chords are not included. Words are converted to lower case, and the
+// index also has every pair of adjacent words in a line, so that a phrase can
+// be found without checking every page where each of its words occurs.
+//
+// An index is built by adding each song and line as it is laid out, and then
+// written to a file. The file can be memory mapped and searched directly: it
+// has a header, a record for each song, a sorted record for each term, the
+// list of (song, page) pairs for each term, and then the text, all of which
+// are made of 32-bit numbers. Songs are numbered in the order they appear in
+// the book, and pages are numbered starting from 1 for the first page of the
+// book, not counting how the pages are arranged on each sheet.
+class SearchIndex {
+public:
+	// A page that a word was found on, and the song it is in.
+	class Match {
+	public:
+		uint32_t song;
+		uint32_t page;
+		
+		bool operator<(const Match &other) const;
+		bool operator==(const Match &other) const;
+	};
+	
+	
+public:
+	SearchIndex() = default;
+	// Open an index file to search it.
+	explicit SearchIndex(const string &path);
+	// Don't allow copying.
+	SearchIndex(const SearchIndex &) = delete;
+	SearchIndex &operator=(const SearchIndex &) = delete;
+	~SearchIndex();
+	
+	// Start adding the lines of a new song, which starts on the given page
+	// (counting from zero).
+	void Add(const Song &song, size_t page);
+	// Add the words of a line of the current song, which is on the given page.
+	void Add(const Line &line, size_t page);
+	// Shift the pages that have been added, because the given number of pages
+	// were inserted before them. Only pages at or after the given position
+	// are moved.
+	void Shift(size_t pages, size_t from = 0);
+	// Write out the index. This returns false if the file can't be written.
+	bool Write(const string &path) const;
+	
+	// Find every page that includes all the words of the given text, sorted
+	// by song and page. This only works with an index loaded from a file.
+	vector<Match> Find(const string &text) const;
+	// Get the title of the given song.
+	const char *Title(uint32_t song) const;
+	
+	
+private:
+	// Get the sorted list of pages that have the given term.
+	pair<const Match *, const Match *> Pages(const string &term) const;
+	
+	
+private:
+	// While building, the title and first page of each song, and the pages
+	// that each term appears on.
+	vector<pair<string, uint32_t>> songs;
+	map<string, vector<Match>> terms;
+	
+	// When searching, the memory mapped file.
+	const char *data = nullptr;
+	size_t size = 0;
+};
+
+
+
+#endif
@@ -12,10 +12,36 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Song.h"
 
+#include "Unicode.h"
+
 #include <fstream>
+#include <set>
 
 using namespace std;
 
+namespace {
+	// File extensions that are used for ChordPro files.
+	const string CHORDPRO_EXTENSIONS[] = {".cho", ".chopro", ".chordpro", ".crd", ".pro"};
+	// A line with only this on it separates songs in a stream.
+	const string SONG_BREAK = "\f";
+	// Metadata keys that may come right after the title, instead of a subtitle.
+	// Any key may be used after the subtitle, but right after the title only
+	// these are recognized, so that a subtitle such as "traditional: arr. by
+	// J. Smith" is not mistaken for metadata.
+	const set<string> HEADER_KEYS = {"album", "author", "capo", "ccli", "copyright", "key", "season", "tag",
+		"tempo", "time", "year"};
+	
+	// Copy the given line, trimming leading and trailing whitespace and
+	// squashing any multiple spaces into a single space.
+	void Squash(const string &line, string &output);
+	// Split a "{key: value}" directive into its key and its value. Ignore
+	// leading whitespace after the colon.
+	void Split(const string &line, string &key, string &value);
+	// Check if the given header line is of the form "key: value", where the
+	// key is a lower case word, and if so split it into those two parts.
+	bool SplitMetadata(const string &line, string &key, string &value);
+}
+
 
 
 // Constructor.
@@ -30,19 +56,96 @@ Song::Song(const string &path)
 void Song::Load(const string &path)
 {
 	ifstream in(path);
+	Load(in, IsChordPro(path));
+}
+
+
+
+// Load a song from a stream.
+void Song::Load(istream &in, bool isChordPro)
+{
+	// Skip any empty lines between this song and the one before it.
+	in >> ws;
+	
+	// A ChordPro file almost always starts with a directive.
+	if(isChordPro || in.peek() == '{')
+		LoadChordPro(in);
+	else
+		LoadText(in);
+}
+
+
+
+// Check if the given path has a ChordPro file extension.
+bool Song::IsChordPro(const string &path)
+{
+	for(const string &extension : CHORDPRO_EXTENSIONS)
+		if(path.length() > extension.length()
+				&& !path.compare(path.length() - extension.length(), extension.length(), extension))
+			return true;
+	return false;
+}
+
+
+
+// Access the song information.
+const string &Song::Title() const
+{
+	return title;
+}
+
+
+
+const string &Song::Subtitle() const
+{
+	return subtitle;
+}
+
+
+
+// Get the optional metadata from the song's header.
+const string &Song::Metadata(const string &key) const
+{
+	static const string EMPTY;
+	auto it = metadata.find(key);
+	return (it == metadata.end() ? EMPTY : it->second);
+}
+
+
+
+const map<string, string> &Song::Metadata() const
+{
+	return metadata;
+}
+
+
+
+// Read a song in this program's own format: a title line, an optional
+// subtitle line, optional "key: value" metadata lines, an empty line, and
+// then the text of the song.
+void Song::LoadText(istream &in)
+{
 	string line;
+	string key;
+	string value;
 	
-	// The lines up to the first empty line are the title and subtitle.
+	// The lines up to the first empty line are the title, the subtitle, and
+	// the metadata. A song with no subtitle may still have metadata, so the
+	// line after the title is only the subtitle if it is not metadata with
+	// one of the well-known keys.
 	getline(in, title);
-	if(!title.empty())
+	if(!title.empty() && getline(in, line) && !line.empty())
 	{
-		getline(in, subtitle);
-		if(!subtitle.empty())
-			getline(in, line);
+		if(SplitMetadata(line, key, value) && HEADER_KEYS.count(key))
+			AddMetadata(key, value);
+		else
+			subtitle = line;
+		while(getline(in, line) && SplitMetadata(line, key, value))
+			AddMetadata(key, value);
 	}
 	
 	// The rest of the lines are the text of the song.
-	while(getline(in, line))
+	while(getline(in, line) && line != SONG_BREAK)
 	{
 		// Check if this is a comment.
 		size_t pos = 0;
@@ -58,15 +161,177 @@ void Song::Load(const string &path)
 
 
 
-// Access the song information.
-const string &Song::Title() const
+// Read a song in ChordPro format. The title and subtitle come from directives,
+// choruses are indented, and comments become subtext.
+void Song::LoadChordPro(istream &in)
 {
-	return title;
+	bool isChorus = false;
+	string raw;
+	string line;
+	string key;
+	string value;
+	while(getline(in, raw) && raw != SONG_BREAK)
+	{
+		bool leadingWhite = (!raw.empty() && raw[0] <= ' ' && raw[0] > 0);
+		
+		// First, strip leading and trailing whitespace. Multiple empty lines
+		// in a row count as just one.
+		Squash(raw, line);
+		if(line.empty())
+		{
+			if(!empty() && !back().empty())
+				emplace_back();
+			continue;
+		}
+		if(line.front() == '#')
+			continue;
+		if(line.front() == '{' && line.back() == '}')
+		{
+			Split(line, key, value);
+			// A new song directive ends this song, unless it comes first.
+			if((key == "ns" || key == "new_song") && !(title.empty() && empty()))
+				break;
+			if(key == "t" || key == "title")
+				title = value;
+			else if(key == "st" || key == "subtitle")
+				subtitle = value;
+			else if(key == "key" || key == "tag")
+				AddMetadata(key, value);
+			else if(key == "artist" || key == "composer" || key == "lyricist")
+				AddMetadata("author", value);
+			else if(key == "meta")
+			{
+				// "{meta: name value}" can give any other metadata. Metadata
+				// keys are always lower case, so they can be looked up.
+				size_t space = value.find(' ');
+				if(space != string::npos)
+				{
+					string name = value.substr(0, space);
+					for(char &c : name)
+						c = Unicode::LowerCase(c);
+					AddMetadata(name, value.substr(space + 1));
+				}
+			}
+			else if(key == "soc" || key == "start_of_chorus")
+				isChorus = true;
+			else if(key == "eoc" || key == "end_of_chorus")
+				isChorus = false;
+			else if(key == "c" || key == "comment"
+					|| key == "ci" || key == "comment_italic"
+					|| key == "cb" || key == "comment_box")
+				emplace_back("{" + value + "}", isChorus);
+			continue;
+		}
+		emplace_back(line, isChorus || leadingWhite);
+	}
+	// Don't end the song with an empty line.
+	if(!empty() && back().empty())
+		pop_back();
 }
 
 
 
-const string &Song::Subtitle() const
+// Add a metadata value, joining it to any earlier value for the same key.
+void Song::AddMetadata(const string &key, const string &value)
 {
-	return subtitle;
+	string &entry = metadata[key];
+	if(!entry.empty())
+		entry += ", ";
+	entry += value;
+}
+
+
+
+// Get the size that this song's text should be laid out at.
+double Song::TextSize() const
+{
+	return textSize;
+}
+
+
+
+// Override the size that this song's text should be laid out at.
+void Song::SetTextSize(double points)
+{
+	textSize = points;
+}
+
+
+
+// Transpose all the chords by the given number of semitones from the key the
+// song was written in.
+bool Song::Transpose(int semitones)
+{
+	bool changed = false;
+	for(Line &line : *this)
+		for(Block &block : line)
+			changed |= block.Transpose(semitones);
+	return changed;
+}
+
+
+
+namespace {
+	// Copy the given line, trimming leading and trailing whitespace and
+	// squashing any multiple spaces into a single space.
+	void Squash(const string &line, string &output)
+	{
+		output.clear();
+		bool wasSpace = true;
+		for(char c : line)
+		{
+			bool isSpace = (c <= ' ' && c > 0);
+			if(!isSpace || !wasSpace)
+				output += (isSpace ? ' ' : c);
+			wasSpace = isSpace;
+		}
+		if(!output.empty() && output.back() == ' ')
+			output.pop_back();
+	}
+	
+	
+	
+	// Split a "{key: value}" directive into its key and its value. Ignore
+	// leading whitespace after the colon.
+	void Split(const string &line, string &key, string &value)
+	{
+		// Find the colon, if there is one.
+		size_t split = line.find(':');
+		if(split == string::npos)
+			split = line.length() - 1;
+		
+		// Everything before the colon is the key.
+		key.assign(line, 1, split - 1);
+		
+		// Ignore any spaces after the colon and before the value.
+		++split;
+		while(split < line.length() && line[split] <= ' ' && line[split] >= 0)
+			++split;
+		if(split < line.length() - 1)
+			value.assign(line, split, line.length() - 1 - split);
+		else
+			value.clear();
+	}
+	
+	
+	
+	// Check if the given header line is of the form "key: value", where the
+	// key is a lower case word, and if so split it into those two parts.
+	bool SplitMetadata(const string &line, string &key, string &value)
+	{
+		size_t colon = line.find(':');
+		if(colon == string::npos || !colon)
+			return false;
+		for(size_t i = 0; i < colon; ++i)
+			if(!((line[i] >= 'a' && line[i] <= 'z') || line[i] == '-' || line[i] == '_'))
+				return false;
+		
+		key.assign(line, 0, colon);
+		size_t start = line.find_first_not_of(" \t\r", colon + 1);
+		if(start == string::npos)
+			value.clear();
+		else
+			value.assign(line, start, line.find_last_not_of(" \t\r") + 1 - start);
+		return true;
+	}
 }
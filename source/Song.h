@@ -15,6 +15,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Line.h"
 
+#include <istream>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -29,17 +31,48 @@ public:
 	Song() = default;
 	explicit Song(const string &path);
 	
-	// Load a song from a file.
+	// Load a song from a file or a stream. The file may either be in this
+	// program's own format or in ChordPro format, which is detected by the
+	// file extension or by the first line being a {directive}. A stream may
+	// hold several songs, separated by a line with just a form feed on it (or
+	// a {new_song} directive in ChordPro); this reads up to the next break.
 	void Load(const string &path);
+	void Load(istream &in, bool isChordPro = false);
+	// Check if the given path has a ChordPro file extension.
+	static bool IsChordPro(const string &path);
 	
 	// Access the song information.
 	const string &Title() const;
 	const string &Subtitle() const;
+	// Get the optional metadata (key, tags, author, etc.) from the song's
+	// header. If a key is given more than once, the values are joined with
+	// commas. Keys are always lower case.
+	const string &Metadata(const string &key) const;
+	const map<string, string> &Metadata() const;
+	
+	// Get or set the size that this song's text should be laid out at, instead
+	// of the configured text size. Zero means there is no override.
+	double TextSize() const;
+	void SetTextSize(double points);
+	
+	// Transpose all the chords by the given number of semitones from the key
+	// the song was written in. This returns false if no chords changed.
+	bool Transpose(int semitones);
+	
+	
+private:
+	// Read the rest of a song in each of the supported formats.
+	void LoadText(istream &in);
+	void LoadChordPro(istream &in);
+	// Add a metadata value, joining it to any earlier value for the same key.
+	void AddMetadata(const string &key, const string &value);
 	
 	
 private:
 	string title;
 	string subtitle;
+	map<string, string> metadata;
+	double textSize = 0.;
 };
 
 
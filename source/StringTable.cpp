@@ -0,0 +1,94 @@
+/* StringTable.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "StringTable.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+	// The strings are stored in fixed-size chunks that are never moved, so a
+	// string can be looked up without locking even while others are added.
+	const uint32_t CHUNK_BITS = 12;
+	const uint32_t CHUNK_SIZE = 1 << CHUNK_BITS;
+	const uint32_t MAX_CHUNKS = 1 << 16;
+	atomic<string *> chunks[MAX_CHUNKS];
+	atomic<uint32_t> size(0);
+	
+	// Map from each string to its ID. The keys point to the stored strings,
+	// so that each string's text is only stored once. This is only used when
+	// adding strings, and is always accessed with the lock held.
+	class Hash {
+	public:
+		size_t operator()(const string *text) const { return hash<string>()(*text); }
+	};
+	class Equal {
+	public:
+		bool operator()(const string *a, const string *b) const { return *a == *b; }
+	};
+	unordered_map<const string *, uint32_t, Hash, Equal> ids;
+	mutex tableLock;
+}
+
+
+
+// Get the ID of the given string, adding it to the table if necessary.
+uint32_t StringTable::Intern(const string &text)
+{
+	lock_guard<mutex> guard(tableLock);
+	// The empty string is always the first one in the table.
+	if(!size)
+	{
+		chunks[0] = new string[CHUNK_SIZE];
+		ids[chunks[0]] = EMPTY;
+		size = 1;
+	}
+	auto it = ids.find(&text);
+	if(it != ids.end())
+		return it->second;
+	
+	uint32_t id = size;
+	string *chunk = chunks[id >> CHUNK_BITS];
+	if(!chunk)
+	{
+		chunk = new string[CHUNK_SIZE];
+		chunks[id >> CHUNK_BITS] = chunk;
+	}
+	string &stored = chunk[id & (CHUNK_SIZE - 1)];
+	stored = text;
+	ids.emplace(&stored, id);
+	size = id + 1;
+	return id;
+}
+
+
+
+// Get the string with the given ID.
+const string &StringTable::Get(uint32_t id)
+{
+	static const string EMPTY_STRING;
+	if(id >= size)
+		return EMPTY_STRING;
+	
+	return chunks[id >> CHUNK_BITS].load()[id & (CHUNK_SIZE - 1)];
+}
+
+
+
+// Get the number of strings in the table.
+uint32_t StringTable::Size()
+{
+	return size;
+}
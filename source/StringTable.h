@@ -0,0 +1,45 @@
+/* StringTable.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef STRING_TABLE_H_
+#define STRING_TABLE_H_
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+
+
+// A single table of all the distinct strings used by the program, so that
+// text that repeats (chord names, chorus lines, etc.) is only stored once and
+// can be referred to by a small integer ID. Strings are never removed, so an
+// ID stays valid for the whole run. Adding strings is safe from any thread,
+// and looking up an ID that has already been returned never needs a lock.
+class StringTable {
+public:
+	// The ID of the empty string.
+	static const uint32_t EMPTY = 0;
+	
+	
+public:
+	// Get the ID of the given string, adding it to the table if necessary.
+	static uint32_t Intern(const string &text);
+	// Get the string with the given ID.
+	static const string &Get(uint32_t id);
+	// Get the number of strings in the table. Every ID is less than this.
+	static uint32_t Size();
+};
+
+
+
+#endif
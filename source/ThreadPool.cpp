@@ -0,0 +1,148 @@
+/* ThreadPool.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+	// The pool that the current thread is a worker in, if any, and the index
+	// of its queue.
+	thread_local const ThreadPool *currentPool = nullptr;
+	thread_local size_t currentQueue = 0;
+}
+
+
+
+// Constructor, specifying the number of threads (or 0 for one per core).
+ThreadPool::ThreadPool(size_t count)
+	: nextQueue(0), queued(0)
+{
+	if(!count)
+		count = max(1u, thread::hardware_concurrency());
+	for(size_t i = 0; i < count; ++i)
+		queues.emplace_back();
+	for(size_t i = 0; i < count; ++i)
+		threads.emplace_back(&ThreadPool::Work, this, i);
+}
+
+
+
+// Wait for all tasks to finish, then stop the threads.
+ThreadPool::~ThreadPool()
+{
+	Wait();
+	{
+		unique_lock<mutex> guard(lock);
+		isDone = true;
+	}
+	hasTask.notify_all();
+	for(thread &it : threads)
+		it.join();
+}
+
+
+
+// Add a task to be run on one of the worker threads. A task that adds another
+// task puts it on its own worker's queue, since it will most likely be the
+// next thing that worker needs.
+void ThreadPool::Add(const function<void()> &task)
+{
+	// Count the task before it is queued, so that even if another worker takes
+	// it and finishes it right away, neither count can drop below zero, and a
+	// task that adds more tasks is never counted as done before they are.
+	{
+		unique_lock<mutex> guard(lock);
+		++queued;
+		++pending;
+	}
+	size_t index = (currentPool == this ? currentQueue : nextQueue++ % queues.size());
+	{
+		Queue &queue = queues[index];
+		unique_lock<mutex> guard(queue.lock);
+		queue.tasks.push_back(task);
+	}
+	hasTask.notify_one();
+}
+
+
+
+// Wait until every task that has been added so far is done.
+void ThreadPool::Wait()
+{
+	unique_lock<mutex> guard(lock);
+	while(pending)
+		isIdle.wait(guard);
+}
+
+
+
+void ThreadPool::Work(size_t index)
+{
+	currentPool = this;
+	currentQueue = index;
+	function<void()> task;
+	while(true)
+	{
+		if(!Take(index, task))
+		{
+			// Sleep until there is something to do. Another worker may have
+			// taken a task but not counted it yet, so check again if the
+			// count says there is still one left.
+			unique_lock<mutex> guard(lock);
+			while(!queued && !isDone)
+				hasTask.wait(guard);
+			if(!queued)
+				return;
+			continue;
+		}
+		
+		task();
+		task = nullptr;
+		
+		unique_lock<mutex> guard(lock);
+		if(!--pending)
+			isIdle.notify_all();
+	}
+}
+
+
+
+// Take a task from the given worker's queue, or steal one from another worker.
+bool ThreadPool::Take(size_t index, function<void()> &task)
+{
+	for(size_t i = 0; i < queues.size(); ++i)
+	{
+		Queue &queue = queues[(index + i) % queues.size()];
+		unique_lock<mutex> guard(queue.lock);
+		if(queue.tasks.empty())
+			continue;
+		
+		// Take the newest task from this worker's own queue, and the oldest
+		// from any other queue.
+		if(!i)
+		{
+			task = move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+		--queued;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,84 @@
+/* ThreadPool.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+
+// A fixed set of worker threads that run tasks. By default there is one thread
+// for each processor core. Each worker has its own queue: tasks added from
+// outside the pool are dealt out to the queues in turn, and tasks added by a
+// running task go on its own worker's queue. A worker takes the newest task
+// from its own queue, and if that is empty it steals the oldest task from
+// another worker, so long and short tasks even out without all the workers
+// contending for one shared queue.
+class ThreadPool {
+public:
+	explicit ThreadPool(size_t threads = 0);
+	// Don't allow copying.
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+	// Wait for all tasks to finish, then stop the threads.
+	~ThreadPool();
+	
+	// Add a task to be run on one of the worker threads.
+	void Add(const function<void()> &task);
+	// Wait until every task that has been added so far is done. This must not
+	// be called from within a task.
+	void Wait();
+	
+	
+private:
+	void Work(size_t index);
+	// Take a task from the given worker's queue, or steal one from another
+	// worker. This returns false if all the queues are empty.
+	bool Take(size_t index, function<void()> &task);
+	
+	
+private:
+	class Queue {
+	public:
+		deque<function<void()>> tasks;
+		mutex lock;
+	};
+	
+	
+private:
+	vector<thread> threads;
+	deque<Queue> queues;
+	// The queue that the next task from outside the pool will be added to.
+	atomic<size_t> nextQueue;
+	// Number of tasks that are waiting in any of the queues.
+	atomic<size_t> queued;
+	// Number of tasks that have been added but not finished yet.
+	size_t pending = 0;
+	bool isDone = false;
+	
+	mutex lock;
+	condition_variable hasTask;
+	condition_variable isIdle;
+};
+
+
+
+#endif
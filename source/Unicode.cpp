@@ -0,0 +1,85 @@
+/* Unicode.cpp
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Unicode.h"
+
+using namespace std;
+
+
+
+// Get the character at the given position of the text, and its length.
+uint32_t Unicode::Decode(const string &text, size_t pos, size_t &length)
+{
+	unsigned char first = text[pos];
+	length = 1;
+	if(first < 0x80)
+		return first;
+	
+	size_t extra = (first >= 0xF0 && first < 0xF8) ? 3 : (first >= 0xE0 && first < 0xF0) ? 2 : (first >= 0xC0 && first < 0xE0);
+	if(!extra || pos + extra >= text.length())
+		return INVALID;
+	
+	uint32_t code = first & (0x3F >> extra);
+	for(size_t i = 1; i <= extra; ++i)
+	{
+		unsigned char next = text[pos + i];
+		if((next & 0xC0) != 0x80)
+			return INVALID;
+		code = (code << 6) | (next & 0x3F);
+	}
+	length = extra + 1;
+	return code;
+}
+
+
+
+// Check if a character is whitespace. This includes the byte order mark, which
+// some editors put at the start of a file.
+bool Unicode::IsSpace(uint32_t c)
+{
+	return c <= ' ' || c == 0xA0 || c == 0x1680 || (c >= 0x2000 && c <= 0x200A) || c == 0x2028
+		|| c == 0x2029 || c == 0x202F || c == 0x205F || c == 0x3000 || c == 0xFEFF;
+}
+
+
+
+// Get the length of the whitespace character at the given position.
+size_t Unicode::SpaceLength(const string &text, size_t pos)
+{
+	if(pos >= text.length())
+		return 0;
+	
+	size_t length = 0;
+	return IsSpace(Decode(text, pos, length)) ? length : 0;
+}
+
+
+
+// Check if two strings are the same, ignoring the case of ASCII letters.
+// Bytes that are part of a UTF-8 character are compared exactly.
+bool Unicode::SameText(const string &a, const string &b)
+{
+	if(a.length() != b.length())
+		return false;
+	for(size_t i = 0; i < a.length(); ++i)
+		if(LowerCase(a[i]) != LowerCase(b[i]))
+			return false;
+	return true;
+}
+
+
+
+// Convert an ASCII letter to lower case, leaving any other byte as it is.
+char Unicode::LowerCase(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
@@ -0,0 +1,53 @@
+/* Unicode.h
+Copyright (c) 2017 by Michael Zahniser
+
+This program is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef UNICODE_H_
+#define UNICODE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+
+
+// Functions for reading UTF-8 text one character at a time, and for comparing
+// text.
+class Unicode {
+public:
+	// A character that stands in for a byte that is not valid UTF-8.
+	static const uint32_t INVALID = 0xFFFD;
+	
+	
+public:
+	// Get the character at the given position of the text, and its length in
+	// bytes. A byte that is not part of a valid character is returned as
+	// INVALID, with a length of one, so text in some other encoding is still
+	// read one byte at a time and is never taken for something it is not.
+	static uint32_t Decode(const string &text, size_t pos, size_t &length);
+	// Check if a character is whitespace: an ASCII space or control character,
+	// or one of the Unicode spaces.
+	static bool IsSpace(uint32_t c);
+	// Get the length in bytes of the whitespace character at the given
+	// position of the text, or zero if it is not whitespace.
+	static size_t SpaceLength(const string &text, size_t pos);
+	// Check if two strings are the same, ignoring the case of ASCII letters.
+	static bool SameText(const string &a, const string &b);
+	// Convert an ASCII letter to lower case, leaving any other byte as it is.
+	// Unlike tolower(), this is safe to use on the bytes of UTF-8 text.
+	static char LowerCase(char c);
+};
+
+
+
+#endif
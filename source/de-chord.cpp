@@ -13,83 +13,251 @@ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
 PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 */
 
+#include "ThreadPool.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <fstream>
 #include <iostream>
 #include <string>
-#include <utility>
 #include <vector>
 
 using namespace std;
 
+// Convert one ChordPro file, read from the given stream. Return false if it
+// does not have a title.
+bool Convert(istream &in, ostream &out);
+// Find all the files to convert, given a command line argument. That may be a
+// single file, a directory to search for ChordPro files, or "@list" to read a
+// list of paths from a file.
+void FindFiles(const string &arg, vector<string> &paths);
+// Get the path that the converted version of the given file should go to.
+string OutputPath(const string &path, const string &outputDir);
+// Get the modification time of the given file, or 0 if it does not exist.
+time_t ModifiedTime(const string &path);
 // Trim leading and trailing whitespace and squash any multiple spaces into a
-// single space.
-string Squash(const string &line);
+// single space. The output string is passed in so it can be reused.
+void Squash(const string &line, string &output);
 // Split a string into two parts, one of which comes before a colon and one of
 // which comes after. Ignore leading whitespace after the colon.
-pair<string, string> Split(const string &line);
+void Split(const string &line, string &key, string &value);
+// Check if the given string ends with the given ending.
+bool EndsWith(const string &str, const string &end);
 
 
 
 int main(int argc, char *argv[])
 {
-	// Output text:
+	// With no arguments, convert STDIN to STDOUT.
+	if(argc < 2)
+		return !Convert(cin, cout);
+	
+	// Otherwise, this is a batch conversion. "--output=<dir>" says where to
+	// write the converted files; by default, each one goes in the same
+	// directory as the original, with a ".txt" extension.
+	string outputDir;
+	vector<string> paths;
+	for(char **it = argv + 1; *it; ++it)
+	{
+		string arg = *it;
+		if(!arg.compare(0, 9, "--output="))
+			outputDir = arg.substr(9);
+		else
+			FindFiles(arg, paths);
+	}
+	
+	// Convert all the files in parallel. Files whose converted version is
+	// newer than the original are skipped.
+	atomic<int> converted(0);
+	atomic<int> skipped(0);
+	atomic<int> failed(0);
+	{
+		ThreadPool pool;
+		for(const string &path : paths)
+			pool.Add([&path, &outputDir, &converted, &skipped, &failed]()
+			{
+				string outPath = OutputPath(path, outputDir);
+				if(ModifiedTime(outPath) > ModifiedTime(path))
+				{
+					++skipped;
+					return;
+				}
+			
+				ifstream in(path);
+				ofstream out(outPath);
+				if(in && out && Convert(in, out) && out)
+					++converted;
+				else
+				{
+					++failed;
+					cerr << "Failed to convert \"" << path << "\"." << endl;
+				}
+			});
+	}
+	
+	cerr << converted << " converted, " << skipped << " skipped, " << failed << " failed." << endl;
+	return (failed != 0);
+}
+
+
+
+// Convert one ChordPro file, read from the given stream. Return false if it
+// does not have a title.
+bool Convert(istream &in, ostream &out)
+{
+	// Output text. The title and subtitle may come anywhere in the file, but
+	// they are written first, so the rest of the text is collected in a single
+	// buffer rather than being written out right away.
 	string title;
 	string subtitle;
-	vector<string> output;
+	string output;
 	
-	bool isChorus = false;
+	// Buffers that are reused for every line, to avoid reallocating them.
 	string line;
-	while(getline(cin, line))
+	string squashed;
+	string key;
+	string value;
+	
+	bool isChorus = false;
+	bool lastEmpty = true;
+	while(getline(in, line))
 	{
 		bool leadingWhite = (!line.empty() && line[0] <= ' ');
 		
 		// First, strip leading and trailing whitespace.
-		line = Squash(line);
-		if(line.empty())
+		Squash(line, squashed);
+		if(squashed.empty())
 		{
-			if(!output.empty() && !output.back().empty())
-				output.push_back(line);
+			if(!lastEmpty)
+				output += '\n';
+			lastEmpty = true;
 			continue;
 		}
-		if(line.front() == '#')
+		if(squashed.front() == '#')
 			continue;
-		if(line.front() == '{' && line.back() == '}')
+		if(squashed.front() == '{' && squashed.back() == '}')
 		{
-			pair<string, string> split = Split(line);
-			if(split.first == "t" || split.first == "title")
-				title = split.second;
-			else if(split.first == "st" || split.second == "subtitle")
-				subtitle = split.second;
-			else if(split.first == "soc" || split.first == "start_of_chorus")
+			Split(squashed, key, value);
+			if(key == "t" || key == "title")
+				title = value;
+			else if(key == "st" || key == "subtitle")
+				subtitle = value;
+			else if(key == "soc" || key == "start_of_chorus")
 				isChorus = true;
-			else if(split.first == "eoc" || split.first == "end_of_chorus")
+			else if(key == "eoc" || key == "end_of_chorus")
 				isChorus = false;
-			else if(split.first == "c" || split.first == "comment"
-					|| split.first == "ci" || split.first == "comment_italic"
-					|| split.first == "cb" || split.first == "comment_box")
-				output.emplace_back((isChorus ? "\t{" : "{") + split.second + "}");
+			else if(key == "c" || key == "comment"
+					|| key == "ci" || key == "comment_italic"
+					|| key == "cb" || key == "comment_box")
+			{
+				output += (isChorus ? "\t{" : "{");
+				output += value;
+				output += "}\n";
+				lastEmpty = false;
+			}
 			
 			continue;
 		}
 		if(isChorus || leadingWhite)
-			output.emplace_back("\t" + line);
+			output += '\t';
+		output += squashed;
+		output += '\n';
+		lastEmpty = false;
+	}
+	
+	out << title << '\n' << subtitle << "\n\n" << output;
+	out.flush();
+	return !title.empty();
+}
+
+
+
+// Find all the files to convert, given a command line argument.
+void FindFiles(const string &arg, vector<string> &paths)
+{
+	// "@list" means read the paths from the given file, one per line.
+	if(!arg.empty() && arg[0] == '@')
+	{
+		ifstream in(arg.substr(1));
+		string line;
+		while(getline(in, line))
+			if(!line.empty())
+				FindFiles(line, paths);
+		return;
+	}
+	
+	struct stat info;
+	if(stat(arg.c_str(), &info))
+	{
+		cerr << "Cannot find \"" << arg << "\"." << endl;
+		return;
+	}
+	if(!S_ISDIR(info.st_mode))
+	{
+		paths.push_back(arg);
+		return;
+	}
+	
+	// Search the directory (and any subdirectories) for ChordPro files.
+	static const string EXTENSIONS[] = {".cho", ".chopro", ".chordpro", ".crd", ".pro"};
+	DIR *dir = opendir(arg.c_str());
+	if(!dir)
+		return;
+	string prefix = EndsWith(arg, "/") ? arg : arg + '/';
+	while(dirent *entry = readdir(dir))
+	{
+		string name = entry->d_name;
+		if(name.empty() || name[0] == '.')
+			continue;
+		
+		string path = prefix + name;
+		if(!stat(path.c_str(), &info) && S_ISDIR(info.st_mode))
+			FindFiles(path, paths);
 		else
-			output.emplace_back(line);
+			for(const string &extension : EXTENSIONS)
+				if(EndsWith(name, extension))
+				{
+					paths.push_back(path);
+					break;
+				}
 	}
+	closedir(dir);
+}
+
+
+
+// Get the path that the converted version of the given file should go to.
+string OutputPath(const string &path, const string &outputDir)
+{
+	size_t slash = path.rfind('/');
+	size_t dot = path.rfind('.');
+	if(dot == string::npos || (slash != string::npos && dot < slash))
+		dot = path.length();
 	
-	cout << title << endl;
-	cout << subtitle << endl << endl;
-	for(const string &line : output)
-		cout << line << endl;
+	if(outputDir.empty())
+		return path.substr(0, dot) + ".txt";
 	
-	return 0;
+	size_t start = (slash == string::npos ? 0 : slash + 1);
+	return outputDir + (EndsWith(outputDir, "/") ? "" : "/") + path.substr(start, dot - start) + ".txt";
+}
+
+
+
+// Get the modification time of the given file, or 0 if it does not exist.
+time_t ModifiedTime(const string &path)
+{
+	struct stat info;
+	return stat(path.c_str(), &info) ? 0 : info.st_mtime;
 }
 
 
 
 // Trim leading and trailing whitespace.
-string Squash(const string &line)
+void Squash(const string &line, string &output)
 {
-	string output;
+	output.clear();
 	bool wasSpace = true;
 	for(char c : line)
 	{
@@ -101,32 +269,39 @@ string Squash(const string &line)
 	}
 	while(!output.empty() && output.back() <= ' ')
 		output.pop_back();
-	
-	return output;
 }
 
 
 
 // Split a string into two parts, one of which comes before a colon and one of
 // which comes after. Ignore leading whitespace after the colon.
-pair<string, string> Split(const string &line)
+void Split(const string &line, string &key, string &value)
 {
-	pair<string, string> result;
-	
 	// Find the colon, if there is one.
 	size_t split = line.find(':');
 	if(split == string::npos)
 		split = line.length() - 1;
 	
-	// Everythign before the colon is the key.
-	result.first = line.substr(1, split - 1);
+	// Everything before the colon is the key.
+	key.assign(line, 1, split - 1);
 	
 	// Ignore any spaces after the colon and before the value.
 	++split;
 	while(split < line.length() && line[split] <= ' ')
 		++split;
 	if(split < line.length() - 1)
-		result.second = line.substr(split, line.length() - 1 - split);
+		value.assign(line, split, line.length() - 1 - split);
+	else
+		value.clear();
+}
+
+
+
+// Check if the given string ends with the given ending.
+bool EndsWith(const string &str, const string &end)
+{
+	if(end.length() > str.length())
+		return false;
 	
-	return result;
+	return !str.compare(str.length() - end.length(), end.length(), end);
 }
@@ -10,73 +10,626 @@ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
 PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 */
 
+#include "Book.h"
+#include "Catalog.h"
 #include "Config.h"
+#include "Contents.h"
 #include "Song.h"
 #include "Page.h"
+#include "Preview.h"
+#include "Recording.h"
+#include "Renderer.h"
 #include "Fragment.h"
+#include "Manifest.h"
+#include "MinHash.h"
+#include "SearchIndex.h"
+#include "ThreadPool.h"
 
-#include <cairomm/context.h>
-#include <cairomm/surface.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <clocale>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
 using namespace std;
 
+// One of the output files to generate, and the configuration to use for it.
+class Variant {
+public:
+	string path;
+	Config config;
+};
+
+// Build a catalog of all the song files given in the command line, instead of
+// generating a PDF. This is the "re-chord index" command.
+int Index(char **argv);
+// Search the lyrics index of a book for the given text, and print the page
+// and title of each match. This is the "re-chord search" command.
+int Search(char **argv);
+// Find songs that are near duplicates of each other, and print each group of
+// them. This is the "re-chord dedupe" command.
+int Dedupe(char **argv);
+// Get the paths of all the song files given in the command line, including
+// those listed in manifests. Arguments starting with "--" are skipped.
+vector<string> ListSongFiles(char **argv);
+// Compare two files of page hashes, and list which pages and which printed
+// sheets are different. This is the "re-chord diff" command.
+int Diff(char **argv);
+// Generate many books at once, from manifests that draw on a shared pool of
+// songs. Each song file is only parsed once, no matter how many books it is
+// in. This is the "re-chord library" command.
+int Library(char **argv);
+// Lay out each of the given songs on its own, and save their pages so that
+// they can be put together into a book later without laying them out again.
+// This is the "re-chord compile" command.
+int Compile(char **argv);
+// Put together a book from songs that have been compiled, adding new page
+// numbers and an index. This is the "re-chord compose" command.
+int Compose(char **argv);
 // Load the configuration files from the default locations, as well as any .conf
 // files specified in the command line arguments. If STDIN is being redirected,
-// also read configuration from there.
+// also read configuration from there, unless songs are to be read from it.
 Config InitConfig(char **argv);
-// Determine the output file path based on the configuration and the command
-// line arguments. If STDOUT is being redirected, return an empty string to
-// signify that output should be to STDOUT.
-string OutputPath(const Config &config, char **argv);
-// Parse all the files that are left in the command line, and return a vector
+// Determine the output files based on the configuration and the command line
+// arguments, and the configuration overrides for each one. If STDOUT is being
+// redirected, the path is an empty string to signify output to STDOUT.
+vector<Variant> OutputVariants(const Config &config, char **argv);
+// Check if two configurations produce the same pages, so they differ at most
+// in how those pages are arranged on the output sheets.
+bool SameLayout(const Config &a, const Config &b);
+// Parse all the files that are left in the command line, and return a book
 // that contains their parsed contents.
-vector<Song> ParseFiles(char **argv);
-// Lay out the files on pages, including possibly pages at the start or end for
-// the table of contents.
-vector<Page> Layout(const vector<Song> &songs, const string &indexLocation, const string &layout);
-// Render the pages, saving them in PDF form to the give path. If the path is
-// empty, write the results to STDOUT instead.
+Book ParseFiles(char **argv);
+// Read the songs in all the files left in the command line, one at a time,
+// and pass each one to the given function along with the name of the section
+// that it starts, if any. A file named "-" means STDIN, and a ".book" file is
+// a manifest listing the song files to read.
+void ReadSongs(char **argv, const function<void(Song &, const string &)> &use);
+// Read all the songs from one stream. The given section name is passed along
+// with the first song, and then cleared.
+void ReadSongs(istream &in, bool isChordPro, string &section, const function<void(Song &, const string &)> &use);
+// Check if songs are being read from STDIN, a pipe, or a manifest, and the
+// output can be generated one song at a time as they are read.
+bool CanStream(const vector<Variant> &variants, char **argv);
+// Lay out and render each song as soon as it has been read, instead of first
+// parsing all of them. Pages are freed once they have been drawn.
+void Stream(const Variant &variant, char **argv);
+// Put the chords in the configured key, and if auto-fit is on, pick the text
+// size for each song so it fits on one page.
+void ApplySettings(Book &book, const Config &config);
+// Lay out the given book with the given settings, and split its pages into
+// volumes. Unless the book is split, there is just one volume.
+vector<vector<Page>> Paginate(const Book &book, const Config &config, SearchIndex &search);
+// Write out the pages of the given variant, and its search index and page
+// hashes if they are enabled. Each volume is rendered as a separate task in
+// the given pool, so the pages must be kept until the pool is done. Images
+// are drawn with the given preview, so outputs that share it share its cache.
+void Output(const vector<vector<Page>> &volumes, const Variant &variant, const SearchIndex &search, ThreadPool &pool, Preview &preview);
+// Render the pages, saving them to the given path as a PDF, or as a web page if
+// the path ends in ".html". If the path is empty, write a PDF to STDOUT.
 void Render(const vector<Page> &pages, const string &layout, const string &path);
+// Get the order that the pages are printed in, for the given layout.
+vector<size_t> PrintOrder(size_t pages, const string &layout);
+// Get the number of pages that are printed on each sheet of paper.
+size_t PagesPerSheet(const string &layout);
+// Write the hash of each page, and of each printed sheet, to the given path.
+// The order lists the pages in the order they are printed in.
+void WriteHashes(const vector<uint64_t> &hashes, const vector<size_t> &order, size_t perSheet, const string &path);
+// Create a renderer for the given path, with the given number of pages side
+// by side on each sheet. If the path is empty, write a PDF to STDOUT.
+unique_ptr<Renderer> CreateRenderer(const string &path, int xPages);
+// Add the bookmarks on the given page to the outline, and remember their
+// destinations so that links can point to them.
+void AddOutline(const Page &page, Renderer &renderer, set<string> &destinations);
+// Draw a page in the given slot on the current sheet, and start a new sheet
+// if that was the last slot. Only links to the given destinations are drawn.
+void DrawPage(const Page &page, Renderer &renderer, int slot, int xPages, const set<string> &destinations);
 
-// Function to write output to STDOUT instead of to a named file.
-Cairo::ErrorStatus Write(const unsigned char *data, unsigned int length);
 // Check if the given string ends with the given ending.
 bool EndsWith(const string &str, const string &end);
+// Get the given path without its extension.
+string Stem(const string &path);
+// Apply a "key=value" setting that was given after "--set" in the command line
+// to the given configuration.
+void SetValue(Config &config, const string &setting);
 
 
 
 int main(int argc, char *argv[])
 {
+	// Sort the index the way the user's language does.
+	setlocale(LC_COLLATE, "");
+	
+	if(argc > 1 && string(argv[1]) == "index")
+		return Index(argv + 1);
+	if(argc > 1 && string(argv[1]) == "search")
+		return Search(argv + 1);
+	if(argc > 1 && string(argv[1]) == "dedupe")
+		return Dedupe(argv + 1);
+	if(argc > 1 && string(argv[1]) == "diff")
+		return Diff(argv + 1);
+	if(argc > 1 && string(argv[1]) == "library")
+		return Library(argv + 1);
+	if(argc > 1 && string(argv[1]) == "compile")
+		return Compile(argv + 1);
+	if(argc > 1 && string(argv[1]) == "compose")
+		return Compose(argv + 1);
+	
 	// Parse the command line and the configuration files.
 	Config config = InitConfig(argv);
-	string path = OutputPath(config, argv);
-	Page::Init(config);
+	vector<Variant> variants = OutputVariants(config, argv);
 	
-	// Parse any files given in the command line.
-	vector<Song> songs = ParseFiles(argv);
+	// If songs are arriving through a pipe, start writing the output while
+	// they are still being generated, if the output settings allow that.
+	if(CanStream(variants, argv))
+	{
+		Stream(variants.front(), argv);
+		return 0;
+	}
 	
-	// Generate the layout of all the pages, without yet writing them out.
-	string indexLocation = config.Text("index-location", "none");
-	string layout = config.Text("layout", "single");
-	vector<Page> pages = Layout(songs, indexLocation, layout);
+	// Parse any files given in the command line. All the outputs share them.
+	Book book = ParseFiles(argv);
+	
+	// Outputs that only differ in how the pages are arranged on each sheet can
+	// share the same layout. Lay out each distinct set of pages in turn, and
+	// render all the outputs that use it in parallel. All rendering must be
+	// finished before the next layout, because it will change the fonts.
+	ThreadPool pool;
+	Preview preview;
+	vector<bool> isDone(variants.size(), false);
+	for(size_t i = 0; i < variants.size(); ++i)
+	{
+		if(isDone[i])
+			continue;
+		Config &config = variants[i].config;
+		Page::Init(config);
+		ApplySettings(book, config);
+		
+		// Generate the layout of all the pages, without yet writing them out.
+		SearchIndex search;
+		vector<vector<Page>> volumes = Paginate(book, config, search);
+		
+		// Write out every variant that uses these pages.
+		for(size_t j = i; j < variants.size(); ++j)
+			if(!isDone[j] && SameLayout(config, variants[j].config))
+			{
+				isDone[j] = true;
+				Output(volumes, variants[j], search, pool, preview);
+			}
+		pool.Wait();
+	}
+	
+	return 0;
+}
+
+
+
+// Build a catalog of all the song files given in the command line, instead of
+// generating a PDF. The files may be listed in manifests, and the catalog is
+// written to "songs.catalog" unless "--output=<path>" is given.
+int Index(char **argv)
+{
+	string path = "songs.catalog";
+	for(char **it = argv + 1; *it; ++it)
+		if(!string(*it).compare(0, 9, "--output="))
+			path = *it + 9;
+	
+	if(!Catalog::Build(ListSongFiles(argv), path))
+	{
+		cerr << "Unable to write \"" << path << "\"." << endl;
+		return 1;
+	}
+	return 0;
+}
+
+
+
+// Search the lyrics index of a book for the given text, and print the page
+// and title of each match.
+int Search(char **argv)
+{
+	if(!argv[1] || !argv[2])
+	{
+		cerr << "Usage: re-chord search <book.search> <text>" << endl;
+		return 1;
+	}
+	SearchIndex search(argv[1]);
+	string text;
+	for(char **it = argv + 2; *it; ++it)
+		text += string(*it) + ' ';
+	
+	vector<SearchIndex::Match> matches = search.Find(text);
+	for(const SearchIndex::Match &match : matches)
+		cout << match.page << '\t' << search.Title(match.song) << endl;
+	return matches.empty();
+}
+
+
+
+// Find songs that are near duplicates of each other, and print each group of
+// them along with how similar each song is to the first one. By default, songs
+// must have 80% of their lyrics in common; "--threshold=<fraction>" changes that.
+int Dedupe(char **argv)
+{
+	double threshold = .8;
+	for(char **it = argv + 1; *it; ++it)
+		if(!string(*it).compare(0, 12, "--threshold="))
+			threshold = atof(*it + 12);
+	
+	// Parse all the songs in parallel. Only the signatures and titles are
+	// kept, not the songs themselves.
+	vector<string> paths = ListSongFiles(argv);
+	vector<MinHash> signatures(paths.size());
+	vector<string> titles(paths.size());
+	{
+		ThreadPool pool;
+		for(size_t i = 0; i < paths.size(); ++i)
+			pool.Add([&paths, &signatures, &titles, i]()
+			{
+				Song song(paths[i]);
+				signatures[i] = MinHash(song);
+				titles[i] = song.Title();
+			});
+	}
+	
+	vector<vector<size_t>> clusters = MinHash::Cluster(signatures, threshold);
+	for(const vector<size_t> &cluster : clusters)
+	{
+		cout << cluster.size() << " near duplicates:" << endl;
+		for(size_t i : cluster)
+			cout << '\t' << static_cast<int>(100. * signatures[i].Similarity(signatures[cluster.front()]) + .5)
+				<< "%\t" << paths[i] << " (" << titles[i] << ")" << endl;
+	}
+	return 0;
+}
+
+
+
+// Compare two files of page hashes, and list which pages and which printed
+// sheets are different. A page or sheet that is only in one of the files also
+// counts as different. Like diff, this returns 1 if anything changed.
+int Diff(char **argv)
+{
+	if(!argv[1] || !argv[2])
+	{
+		cerr << "Usage: re-chord diff <old.hashes> <new.hashes>" << endl;
+		return 2;
+	}
+	
+	// For each file, map each "page <number>" or "sheet <number>" to the rest
+	// of its line: the hash, and for sheets, the pages on it.
+	map<pair<string, size_t>, string> entries[2];
+	for(int i = 0; i < 2; ++i)
+	{
+		ifstream in(argv[i + 1]);
+		string type;
+		size_t number;
+		string rest;
+		while(in >> type >> number && getline(in, rest))
+			entries[i][make_pair(type, number)] = rest;
+	}
+	
+	// Check every entry in the new file against the old one, and then check
+	// for any that were removed.
+	vector<size_t> changed[2];
+	for(const auto &it : entries[1])
+	{
+		auto old = entries[0].find(it.first);
+		if(old == entries[0].end() || old->second != it.second)
+			changed[it.first.first == "sheet"].push_back(it.first.second);
+	}
+	for(const auto &it : entries[0])
+		if(!entries[1].count(it.first))
+			changed[it.first.first == "sheet"].push_back(it.first.second);
+	sort(changed[0].begin(), changed[0].end());
+	sort(changed[1].begin(), changed[1].end());
+	
+	// List the changed pages on one line, and then each changed sheet along
+	// with the pages that are now printed on it.
+	cout << "Changed pages:";
+	for(size_t number : changed[0])
+		cout << ' ' << number;
+	cout << endl << "Changed sheets:" << endl;
+	for(size_t number : changed[1])
+	{
+		auto it = entries[1].find(make_pair(string("sheet"), number));
+		cout << '\t' << number;
+		// The pages come after the hash. If they are missing, the file must
+		// have been edited or cut short, so just show the line as it is.
+		if(it != entries[1].end())
+		{
+			size_t pages = it->second.find(' ', 1);
+			if(pages != string::npos)
+				cout << ": pages" << it->second.substr(pages);
+			else
+				cout << ":" << it->second;
+		}
+		cout << endl;
+	}
+	return !changed[0].empty() || !changed[1].empty();
+}
+
+
+
+// Get the paths of all the song files given in the command line, including
+// those listed in manifests.
+vector<string> ListSongFiles(char **argv)
+{
+	vector<string> paths;
+	for(char **it = argv + 1; *it; ++it)
+	{
+		string arg = *it;
+		if(!arg.compare(0, 2, "--"))
+			continue;
+		if(EndsWith(arg, ".book"))
+		{
+			Manifest manifest(arg);
+			string path;
+			string section;
+			while(manifest.Next(path, section))
+				paths.push_back(path);
+		}
+		else
+			paths.push_back(arg);
+	}
+	return paths;
+}
+
+
+
+// Generate many books at once, from manifests that draw on a shared pool of
+// songs. Each ".book" argument is a book, which is written to a PDF of the
+// same name. "--set key=value" overrides the configuration for the book
+// before it, or for all books if it comes first. "@list" reads more arguments
+// from a file, one book per line.
+int Library(char **argv)
+{
+	Config config = InitConfig(argv);
 	
-	// Lay out the pages, add page numbers, and write the file.
-	Render(pages, layout, path);
+	// Gather the arguments, including any that are in lists.
+	vector<string> args;
+	for(char **it = argv + 1; *it; ++it)
+	{
+		string arg = *it;
+		if(arg[0] != '@')
+		{
+			args.push_back(arg);
+			continue;
+		}
+		ifstream in(arg.substr(1));
+		while(in >> arg)
+			args.push_back(arg);
+	}
+	
+	// Find all the books, and their settings.
+	vector<Variant> books;
+	vector<string> manifests;
+	Config shared = config;
+	for(size_t i = 0; i < args.size(); ++i)
+	{
+		const string &arg = args[i];
+		if(EndsWith(arg, ".book"))
+		{
+			books.push_back({arg.substr(0, arg.length() - 5) + ".pdf", shared});
+			manifests.push_back(arg);
+		}
+		else if(arg == "--set" && i + 1 < args.size())
+			SetValue(books.empty() ? shared : books.back().config, args[++i]);
+		else
+			cerr << "Ignoring \"" << arg << "\": it is not a .book manifest." << endl;
+	}
+	
+	// Read all the manifests, to find every song file that any book uses.
+	vector<vector<pair<string, string>>> contents(books.size());
+	map<string, Book> files;
+	for(size_t i = 0; i < books.size(); ++i)
+	{
+		Manifest manifest(manifests[i]);
+		string path;
+		string section;
+		while(manifest.Next(path, section))
+		{
+			contents[i].emplace_back(path, section);
+			files[path];
+		}
+	}
+	
+	// Parse each song file just once, no matter how many books it is in.
+	ThreadPool pool;
+	for(pair<const string, Book> &file : files)
+		pool.Add([&file]()
+		{
+			file.second.Load(file.first);
+		});
+	pool.Wait();
+	
+	// Lay out all the books that have the same settings together. Page keeps
+	// the layout of every line it has seen until the settings change, so a
+	// song that is in many books is only really laid out once; after that,
+	// its lines are just copied to each new page they land on. The layouts
+	// must all be kept until they have been rendered.
+	Preview preview;
+	vector<bool> isDone(books.size(), false);
+	for(size_t i = 0; i < books.size(); ++i)
+	{
+		if(isDone[i])
+			continue;
+		Config &config = books[i].config;
+		Page::Init(config);
+		for(pair<const string, Book> &file : files)
+			ApplySettings(file.second, config);
+		
+		vector<size_t> group;
+		for(size_t j = i; j < books.size(); ++j)
+			if(!isDone[j] && SameLayout(config, books[j].config))
+			{
+				isDone[j] = true;
+				group.push_back(j);
+			}
+		
+		vector<vector<vector<Page>>> volumes;
+		vector<SearchIndex> search(group.size());
+		for(size_t j = 0; j < group.size(); ++j)
+		{
+			Book book;
+			for(const pair<string, string> &entry : contents[group[j]])
+			{
+				if(!entry.second.empty())
+					book.StartSection(entry.second);
+				const Book &file = files[entry.first];
+				book.insert(book.end(), file.begin(), file.end());
+			}
+			volumes.push_back(Paginate(book, config, search[j]));
+		}
+		
+		// Render all the books, then move on to the next settings.
+		for(size_t j = 0; j < group.size(); ++j)
+			Output(volumes[j], books[group[j]], search[j], pool, preview);
+		pool.Wait();
+	}
 	
 	return 0;
 }
 
 
 
+// Lay out each of the given songs on its own, and save their pages. The songs
+// are written to "songs.pages", unless "--output=<path>" is given. As when
+// generating a book, "--set key=value" overrides the configuration.
+int Compile(char **argv)
+{
+	Config config = InitConfig(argv);
+	string path = "songs.pages";
+	char **out = argv + 1;
+	for(char **it = out; *it; ++it)
+	{
+		string arg = *it;
+		if(!arg.compare(0, 9, "--output="))
+			path = arg.substr(9);
+		else if(arg == "--set" && it[1])
+			SetValue(config, *++it);
+		else
+			*out++ = *it;
+	}
+	*out = nullptr;
+	
+	// Parse all the song files in parallel.
+	vector<string> paths = ListSongFiles(argv);
+	vector<Book> files(paths.size());
+	{
+		ThreadPool pool;
+		for(size_t i = 0; i < paths.size(); ++i)
+			pool.Add([&paths, &files, i]()
+			{
+				files[i].Load(paths[i]);
+			});
+	}
+	
+	// Then lay out each song, with the key and text size it would have in a
+	// book with these same settings.
+	Page::Init(config);
+	Recording recording;
+	for(size_t i = 0; i < paths.size(); ++i)
+	{
+		ApplySettings(files[i], config);
+		for(const Song &song : files[i])
+			recording.Add(song, paths[i]);
+	}
+	if(!recording.Write(path, config))
+	{
+		cerr << "Unable to write \"" << path << "\"." << endl;
+		return 1;
+	}
+	return 0;
+}
+
+
+
+// Put together a book from songs that have been compiled. The first argument
+// is the recording, and the rest are songs, given either as the file they
+// were read from (or a manifest listing those files) or by their titles. The
+// settings are the ones the songs were compiled with, and settings that would
+// change the layout of the songs themselves should not be overridden.
+int Compose(char **argv)
+{
+	if(!argv[1])
+	{
+		cerr << "Usage: re-chord compose <songs.pages> <song>... [output.pdf]" << endl;
+		return 1;
+	}
+	Recording recording(argv[1]);
+	if(!recording.IsOpen())
+	{
+		cerr << "Unable to read \"" << argv[1] << "\"." << endl;
+		return 1;
+	}
+	vector<Variant> variants = OutputVariants(recording.Settings(), argv + 1);
+	
+	// Find all the songs.
+	vector<size_t> songs;
+	for(const string &name : ListSongFiles(argv + 1))
+	{
+		vector<size_t> found = recording.Find(name);
+		if(found.empty())
+			cerr << "Cannot find \"" << name << "\" in \"" << argv[1] << "\"." << endl;
+		songs.insert(songs.end(), found.begin(), found.end());
+	}
+	
+	// The pages are just copied in. Only the index entries are measured.
+	ThreadPool pool;
+	Preview preview;
+	for(Variant &variant : variants)
+	{
+		Page::Init(variant.config);
+		string indexLocation = variant.config.Text("index-location", "none");
+		vector<Page> pages;
+		Contents index(variant.config.Text("index-sort", "none"));
+		for(size_t song : songs)
+		{
+			size_t first = pages.size();
+			if(!recording.Read(song, pages))
+			{
+				cerr << "\"" << argv[1] << "\" is damaged." << endl;
+				return 1;
+			}
+			for(size_t i = first; i < pages.size(); ++i)
+				pages[i].SetNumber(i + 1);
+			index.Add(recording.Title(song), recording.Subtitle(song), recording.FirstLine(song),
+				recording.Author(song), pages[first]);
+		}
+		vector<Page> indexPages;
+		if(indexLocation != "none")
+			indexPages = index.Layout();
+		Book::Assemble(pages, indexPages, indexLocation, variant.config.Text("layout", "single"));
+		
+		// There are no lyrics in the recording to build a search index from.
+		variant.config.Set("search-index", "no");
+		vector<vector<Page>> volumes(1, move(pages));
+		SearchIndex search;
+		Output(volumes, variant, search, pool, preview);
+		pool.Wait();
+	}
+	return 0;
+}
+
+
+
 // Load the configuration files from the default locations, as well as any .conf
 // files specified in the command line arguments. If STDIN is being redirected,
-// also read configuration from there.
+// also read configuration from there, unless songs are to be read from it.
 Config InitConfig(char **argv)
 {
 	// Priority for config values is:
@@ -93,9 +646,11 @@ Config InitConfig(char **argv)
 	// Parse the command line arguments. Anything ending in ".conf" should be
 	// parsed as a configuration file and removed from the arguments.
 	char **out = argv + 1;
+	bool songsFromStdin = false;
 	for(char **it = out; *it; ++it)
 	{
 		string arg = *it;
+		songsFromStdin |= (arg == "-");
 		if(EndsWith(arg, ".conf"))
 			config.Load(arg);
 		else
@@ -106,7 +661,7 @@ Config InitConfig(char **argv)
 	*out = nullptr;
 	
 	// If STDIN is being redirected from a file, read configuration from it.
-	if(!isatty(fileno(stdin)))
+	if(!songsFromStdin && !isatty(fileno(stdin)))
 		config.Load(cin);
 	
 	return config;
@@ -114,40 +669,43 @@ Config InitConfig(char **argv)
 
 
 
-// Determine the output file path based on the configuration and the command
-// line arguments. If STDOUT is being redirected, return an empty string to
-// signify that output should be to STDOUT.
-string OutputPath(const Config &config, char **argv)
+// Determine the output files based on the configuration and the command line
+// arguments, and the configuration overrides for each one. If STDOUT is being
+// redirected, the path is an empty string to signify output to STDOUT.
+vector<Variant> OutputVariants(const Config &config, char **argv)
 {
 	// Priority for output destinations is:
-	// 1. STDOUT, if it is redirected to something other than a tty.
-	// 2. The last "*.pdf" file in the command line arguments (if any).
+	// 1. STDOUT, if it is redirected to something other than a tty (unless
+	//    more than one output file is given in the command line).
+	// 2. All the "*.pdf" files in the command line arguments (if any).
 	// 3. The value of "output" in the configuration.
 	// 4. "out.pdf" if no output value was given.
-	if(!isatty(fileno(stdout)))
-		return "";
-	string path;
+	vector<Variant> variants;
+	Config shared = config;
 	string textPath;
 	int textPathCount = 0;
+	string transpose;
 	
-	// Parse the command line arguments. Anything ending in ".pdf" should be
-	// removed from the arguments, and the last such value is treated as the
-	// output path (unless the output is to STDOUT).
+	// Parse the command line arguments. Anything ending in ".pdf", ".html",
+	// or ".png" should be removed from the arguments and treated as an output
+	// path. A ".png" output is a set of images, one for each page. "--set
+	// key=value" overrides the configuration for the output path before it,
+	// or for all outputs if it comes before any output path. A setting must
+	// be marked that way, because a song file name may have an "=" in it.
 	char **out = argv + 1;
 	for(char **it = out; *it; ++it)
 	{
 		string arg = *it;
-		if(EndsWith(arg, ".pdf"))
-		{
-			if(!path.empty())
-				cerr << "Ignoring command line argument \"" << path << "\"." << endl;
-			
-			path = arg;
-		}
+		if(!arg.compare(0, 12, "--transpose="))
+			transpose = arg.substr(12);
+		else if(EndsWith(arg, ".pdf") || EndsWith(arg, ".html") || EndsWith(arg, ".png"))
+			variants.push_back({arg, shared});
+		else if(arg == "--set" && it[1])
+			SetValue(variants.empty() ? shared : variants.back().config, *++it);
 		else
 		{
-			if(EndsWith(arg, ".txt")) {
-				textPath = arg;
+			if(EndsWith(arg, ".txt") || EndsWith(arg, ".book")) {
+				textPath = arg.substr(0, arg.rfind('.'));
 				++textPathCount;
 			}
 			*out++ = *it;
@@ -155,181 +713,480 @@ string OutputPath(const Config &config, char **argv)
 	}
 	// Mark the new end of the arguments.
 	*out = nullptr;
+	
 	// If no output file was specified, check if the configuration specifies one
 	// and if not, use the default file name:
-	string defaultPath = (textPathCount == 1 ? textPath.substr(0, textPath.size() - 4) + ".pdf" : "out.pdf");
-	if(path.empty())
-		path = config.Text("output", defaultPath);
+	if(variants.empty())
+	{
+		string defaultPath = (textPathCount == 1 ? textPath + ".pdf" : "out.pdf");
+		variants.push_back({shared.Text("output", defaultPath), shared});
+	}
 	
-	return path;
+	// "--transpose=-2,0,3" makes a copy of every output in each of the given
+	// keys, with the number of semitones added to the end of the file name.
+	if(!transpose.empty())
+	{
+		vector<Variant> keys;
+		for(size_t start = 0; start < transpose.length(); )
+		{
+			size_t end = min(transpose.find(',', start), transpose.length());
+			string semitones = transpose.substr(start, end - start);
+			start = end + 1;
+			for(const Variant &variant : variants)
+			{
+				keys.push_back(variant);
+				keys.back().config.Set("transpose", semitones);
+				if(atoi(semitones.c_str()))
+				{
+					string sign = (semitones[0] == '-' ? "" : "+");
+					keys.back().path.insert(Stem(keys.back().path).length(), sign + semitones);
+				}
+			}
+		}
+		variants.swap(keys);
+	}
+	// A book that is split into volumes needs a file for each one.
+	if(variants.size() == 1 && !isatty(fileno(stdout)) && variants.back().config.Text("volumes", "none") == "none"
+			&& EndsWith(variants.back().path, ".pdf"))
+		variants.back().path.clear();
+	
+	return variants;
 }
 
 
 
-// Parse all the files that are left in the command line, and return a vector
+// Parse all the files that are left in the command line, and return a book
 // that contains their parsed contents.
-vector<Song> ParseFiles(char **argv)
+Book ParseFiles(char **argv)
 {
-	vector<Song> songs;
+	Book songs;
+	ReadSongs(argv, [&songs](Song &song, const string &section)
+	{
+		if(!section.empty())
+			songs.StartSection(section);
+		songs.push_back(move(song));
+	});
+	return songs;
+}
+
+
+
+// Read the songs in all the files left in the command line, one at a time,
+// and pass each one to the given function along with the name of the section
+// that it starts, if any.
+void ReadSongs(char **argv, const function<void(Song &, const string &)> &use)
+{
+	string section;
 	for(char **it = argv + 1; *it; ++it)
 	{
-		songs.emplace_back(*it);
+		string path = *it;
+		if(path == "-")
+			ReadSongs(cin, false, section, use);
+		else if(EndsWith(path, ".book"))
+		{
+			// Only open each song file once the previous one is finished.
+			Manifest manifest(path);
+			string name;
+			while(manifest.Next(path, name))
+			{
+				if(!name.empty())
+					section = name;
+				ifstream in(path);
+				ReadSongs(in, Song::IsChordPro(path), section, use);
+			}
+		}
+		else
+		{
+			ifstream in(path);
+			ReadSongs(in, Song::IsChordPro(path), section, use);
+		}
+	}
+}
+
+
+
+// Read all the songs from one stream. The given section name is passed along
+// with the first song, and then cleared.
+void ReadSongs(istream &in, bool isChordPro, string &section, const function<void(Song &, const string &)> &use)
+{
+	while(in)
+	{
+		Song song;
+		song.Load(in, isChordPro);
 		// Make sure a song was actually loaded.
-		if(songs.back().empty() || songs.back().Title().empty())
-			songs.pop_back();
+		if(song.empty() || song.Title().empty())
+			continue;
+		
+		use(song, section);
+		section.clear();
 	}
-	return songs;
 }
 
 
 
-// Lay out the files on pages, including possibly pages at the start or end for
-// the table of contents.
-vector<Page> Layout(const vector<Song> &songs, const string &indexLocation, const string &layout)
+// Check if songs are being read from STDIN, a pipe, or a manifest, and the
+// output can be generated one song at a time as they are read. That is not
+// possible if the layout of any page depends on songs that come after it.
+bool CanStream(const vector<Variant> &variants, char **argv)
 {
-	// Check where the index is supposed to be.
-	bool hasIndex = (indexLocation != "none");
+	if(variants.size() != 1)
+		return false;
+	const Config &config = variants.front().config;
+	string indexLocation = config.Text("index-location", "none");
+	string layout = config.Text("layout", "single");
+	if(layout == "booklet" || layout == "slides" || (indexLocation != "none" && indexLocation != "back")
+			|| config.Text("packing", "none") != "none" || config.Text("auto-fit", "none") != "none"
+			|| config.Text("volumes", "none") != "none" || EndsWith(variants.front().path, ".png"))
+		return false;
 	
-	// Store the index in a separate set of pages, which will be inserted in
-	// the proper place once all the songs have been laid out.
-	vector<Page> pages;
-	vector<Page> index(hasIndex);
+	for(char **it = argv + 1; *it; ++it)
+	{
+		struct stat info;
+		if(string(*it) == "-" || EndsWith(*it, ".book") || (!stat(*it, &info) && S_ISFIFO(info.st_mode)))
+			return true;
+	}
+	return false;
+}
+
+
+
+// Lay out and render each song as soon as it has been read, instead of first
+// parsing all of them. Pages are freed once they have been drawn.
+void Stream(const Variant &variant, char **argv)
+{
+	Config config = variant.config;
+	Page::Init(config);
+	int semitones = static_cast<int>(config.Value("transpose", 0.));
+	bool hasIndex = (config.Text("index-location", "none") == "back");
+	bool hasSearch = (config.Text("search-index", "no") == "yes" && !variant.path.empty());
+	SearchIndex search;
+	bool hasHashes = (config.Text("page-hashes", "no") == "yes" && !variant.path.empty());
+	vector<uint64_t> hashes;
+	int xPages = 1 + (config.Text("layout", "single") == "2up");
+	unique_ptr<Renderer> renderer = CreateRenderer(variant.path, xPages);
 	
-	for(const Song &song : songs)
+	// The first page is held back until there is a second one, because if
+	// the whole output is just one page, it is not numbered. Each page is added
+	// to the outline as it is drawn, and the index comes last, so every link in
+	// it is to a page that has already been drawn.
+	set<string> destinations;
+	vector<Page> pages;
+	Contents index(config.Text("index-sort", "none"));
+	size_t drawn = 0;
+	ReadSongs(argv, [&](Song &song, const string &section)
 	{
-		// Each song starts on a new page.
-		pages.emplace_back(pages.size() + 1);
-		// If we're building an index, add a line for this song.
+		song.Transpose(semitones);
+		size_t first = pages.size();
+		Book::Layout(song, pages, hasSearch ? &search : nullptr);
+		Page::SetTextSize(0.);
+		if(!section.empty())
+			pages[first].AddBookmark(section, 0);
 		if(hasIndex)
 		{
-			string entry = song.Title() + " (" + song.Subtitle() + ")";
-			// Try twice to add a line to the index. If it fails the first time,
-			// that means we need to start a new page.
-			for(int tries = 0; tries < 2; ++tries)
-			{
-				if(index.back().AddLine(TextType::INDEX, entry, pages.back().Number()))
-					break;
-				index.emplace_back();
-			}
+			index.AddSection(section, pages[first]);
+			index.Add(song, pages[first]);
 		}
-		// Lay out this song on the page. Assume there's always space for the
-		// title and the subtitle, so we don't need to check if this succeeds.
-		// Also assume that every song has a title.
-		pages.back().AddLine(TextType::TITLE, song.Title());
-		if(!song.Subtitle().empty())
-			pages.back().AddLine(TextType::SUBTITLE, song.Subtitle());
-		pages.back().EndTitle();
 		
-		// Now, try to lay out each line of the song on the page.
-		for(const Line &line : song)
+		for( ; pages.size() > 1 && drawn < pages.size(); ++drawn)
 		{
-			pages.back().Indent(line.IsIndented());
-			for(const Block &block : line)
-			{
-				// If adding the block doesn't work, start a new page and add it
-				// there. Assume it always works the second time around.
-				for(int tries = 0; tries < 2; ++tries)
-				{
-					if(pages.back().Add(line, block))
-						break;
-					pages.emplace_back(pages.size() + 1);
-					// If we're still at the start of the line, indent.
-					if(&block == &line.front())
-						pages.back().Indent(line.IsIndented());
-				}
-			}
-			pages.back().EndLine(line);
+			pages[drawn].PlaceNumber();
+			AddOutline(pages[drawn], *renderer, destinations);
+			DrawPage(pages[drawn], *renderer, drawn % xPages, xPages, destinations);
+			if(hasHashes)
+				hashes.push_back(pages[drawn].Hash());
+			pages[drawn] = Page();
 		}
+	});
+	
+	// Draw any page that was held back, and then the index.
+	for( ; drawn < pages.size(); ++drawn)
+	{
+		if(hasIndex)
+			pages[drawn].PlaceNumber();
+		AddOutline(pages[drawn], *renderer, destinations);
+		DrawPage(pages[drawn], *renderer, drawn % xPages, xPages, destinations);
+		if(hasHashes)
+			hashes.push_back(pages[drawn].Hash());
+	}
+	for(const Page &page : hasIndex ? index.Layout() : vector<Page>())
+	{
+		DrawPage(page, *renderer, drawn++ % xPages, xPages, destinations);
+		if(hasHashes)
+			hashes.push_back(page.Hash());
 	}
 	
-	// Insert the index.
-	if(indexLocation == "front")
-		pages.insert(pages.begin(), index.begin(), index.end());
-	else if(indexLocation == "back")
-		pages.insert(pages.end(), index.begin(), index.end());
+	// The pages are printed in order, so each sheet is just the next few.
+	if(hasHashes)
+	{
+		vector<size_t> order;
+		for(size_t i = 0; i < hashes.size(); ++i)
+			order.push_back(i);
+		WriteHashes(hashes, order, xPages, Stem(variant.path) + ".hashes");
+	}
 	
-	// If there is only one page, don't number it.
-	if(pages.size() <= 1)
-		return pages;
+	if(hasSearch)
+		search.Write(Stem(variant.path) + ".search");
+}
+
+
+
+// Put the chords in the configured key, and if auto-fit is on, pick the text
+// size for each song so it fits on one page.
+void ApplySettings(Book &book, const Config &config)
+{
+	book.Transpose(static_cast<int>(config.Value("transpose", 0.)));
 	
-	// Place all the page numbers. If this is a booklet, the numbers will
-	// alternate right and left sides. Otherwise they're all centered.
-	int side = (layout == "booklet");
-	for(Page &page : pages)
+	for(Song &song : book)
+		song.SetTextSize(0.);
+	if(config.Text("auto-fit", "none") == "page")
 	{
-		page.PlaceNumber(side);
-		side = -side;
+		double textSize = config.Value("text-size", 12);
+		book.Fit(config.Value("fit-min-size", .5 * textSize), config.Value("fit-max-size", 2. * textSize));
 	}
-	// If the layout is booklet, the number of pages must be a multiple of four.
-	while(side && pages.size() & 3)
-		pages.emplace_back();
+}
+
+
+
+// Lay out the given book with the given settings, and split its pages into
+// volumes.
+vector<vector<Page>> Paginate(const Book &book, const Config &config, SearchIndex &search)
+{
+	string indexLocation = config.Text("index-location", "none");
+	string layout = config.Text("layout", "single");
+	string packing = config.Text("packing", "none");
+	bool hasSearch = (config.Text("search-index", "no") == "yes");
+	vector<Page> pages;
+	if(layout == "slides")
+	{
+		// Slides are fitted to the screen one stanza at a time, so they can
+		// use much bigger text than a printed page.
+		double textSize = config.Value("text-size", 12);
+		pages = book.Slides(config.Value("fit-min-size", textSize), config.Value("fit-max-size", 6. * textSize), hasSearch ? &search : nullptr);
+	}
+	else
+		pages = book.Layout(indexLocation, layout, packing, config.Text("volumes", "none"),
+			config.Text("index-sort", "none"), hasSearch ? &search : nullptr);
 	
-	return pages;
+	// Each page knows which volume it is in, and the volumes are in order.
+	vector<vector<Page>> volumes(1);
+	for(Page &page : pages)
+	{
+		if(!volumes.back().empty() && page.Volume() != volumes.back().back().Volume())
+			volumes.emplace_back();
+		volumes.back().push_back(move(page));
+	}
+	return volumes;
+}
+
+
+
+// Write out the pages of the given variant, and its search index and page
+// hashes if they are enabled. If there are several volumes, each one is
+// written to its own file, numbered starting from 1.
+void Output(const vector<vector<Page>> &volumes, const Variant &variant, const SearchIndex &search, ThreadPool &pool, Preview &preview)
+{
+	string layout = variant.config.Text("layout", "single");
+	bool hasHashes = (variant.config.Text("page-hashes", "no") == "yes" && !variant.path.empty());
+	for(size_t v = 0; v < volumes.size(); ++v)
+	{
+		string path = variant.path;
+		if(volumes.size() > 1)
+			path.insert(Stem(path).length(), "-" + to_string(v + 1));
+		if(EndsWith(path, ".png"))
+		{
+			// Each page is a separate image, and each distinct page is drawn
+			// by a separate task, which writes every page that looks the same
+			// (such as the slides of a repeated chorus). The outputs share one
+			// cache of images, so pages that are the same in more than one
+			// output are only drawn once, too.
+			double dpi = variant.config.Value("preview-dpi", 96.);
+			map<uint64_t, vector<size_t>> same;
+			for(size_t i = 0; i < volumes[v].size(); ++i)
+				same[volumes[v][i].Hash()].push_back(i);
+			
+			string base = Stem(path);
+			const vector<Page> &pages = volumes[v];
+			for(const auto &it : same)
+			{
+				vector<size_t> numbers = it.second;
+				pool.Add([&preview, &pages, numbers, dpi, base]()
+				{
+					string png = preview.Render(pages[numbers.front()], dpi);
+					for(size_t i : numbers)
+						ofstream(base + "-" + to_string(i + 1) + ".png", ios::binary) << png;
+				});
+			}
+		}
+		else
+			pool.Add([&volumes, v, layout, path]()
+			{
+				Render(volumes[v], layout, path);
+			});
+		
+		if(hasHashes)
+		{
+			vector<uint64_t> hashes;
+			for(const Page &page : volumes[v])
+				hashes.push_back(page.Hash());
+			WriteHashes(hashes, PrintOrder(volumes[v].size(), layout), PagesPerSheet(layout),
+				Stem(path) + ".hashes");
+		}
+	}
+	if(variant.config.Text("search-index", "no") == "yes" && !variant.path.empty())
+		search.Write(Stem(variant.path) + ".search");
 }
 
 
 
-// Render the pages, saving them in PDF form to the give path. If the path is
-// empty, write the results to STDOUT instead.
+// Render the pages, saving them to the given path as a PDF, or as a web page if
+// the path ends in ".html". If the path is empty, write a PDF to STDOUT.
 void Render(const vector<Page> &pages, const string &layout, const string &path)
 {
-	double width = Page::Width();
-	double height = Page::Height();
+	// Multiple song pages may go on each PDF page.
 	int xPages = 1 + (layout == "2up" || layout == "booklet");
-	int yPages = 1;
+	unique_ptr<Renderer> renderer = CreateRenderer(path, xPages);
 	
-	// Create the output context.
-	Cairo::RefPtr<Cairo::PdfSurface> surface;
-	if(path.empty())
-		surface = Cairo::PdfSurface::create_for_stream(&Write, width * xPages, height * yPages);
-	else
-		surface = Cairo::PdfSurface::create(path, width * xPages, height * yPages);
-	Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create(surface);
-	
-	// Multiple song pages may go on each PDF page.
-	int x = 0;
-	int y = 0;
+	// The outline lists the songs in the order they are in the book, even if
+	// the pages are printed in a different order.
+	set<string> destinations;
+	for(const Page &page : pages)
+		AddOutline(page, *renderer, destinations);
 	
+	// Render each page. The pages may be shared with other outputs, so they
+	// are not rearranged, just drawn in a different order.
+	vector<size_t> order = PrintOrder(pages.size(), layout);
+	for(size_t i = 0; i < order.size(); ++i)
+		DrawPage(pages[order[i]], *renderer, i % xPages, xPages, destinations);
+}
+
+
+
+// Get the order that the pages are printed in, for the given layout.
+vector<size_t> PrintOrder(size_t pages, const string &layout)
+{
 	// Special case: booklet layout. The page order is N, 1, 2, N - 1, N - 2, 3, 4, ...
-	vector<Page> reordered;
+	vector<size_t> order;
 	if(layout == "booklet")
 	{
-		vector<Page>::const_iterator forwardIt = pages.begin();
-		vector<Page>::const_iterator backwardIt = pages.end();
-		
-		while(forwardIt < backwardIt)
+		size_t forward = 0;
+		size_t backward = pages;
+		while(forward < backward)
 		{
-			reordered.push_back(*--backwardIt);
-			reordered.push_back(*forwardIt++);
-			reordered.push_back(*forwardIt++);
-			reordered.push_back(*--backwardIt);
+			order.push_back(--backward);
+			order.push_back(forward++);
+			order.push_back(forward++);
+			order.push_back(--backward);
 		}
 	}
+	else
+		for(size_t i = 0; i < pages; ++i)
+			order.push_back(i);
+	return order;
+}
+
+
+
+// Get the number of pages that are printed on each sheet of paper. A booklet
+// is printed on both sides of each sheet, with two pages on each side.
+size_t PagesPerSheet(const string &layout)
+{
+	if(layout == "booklet")
+		return 4;
+	return (layout == "2up") ? 2 : 1;
+}
+
+
+
+// Write the hash of each page, and of each printed sheet, to the given path.
+// Each sheet's line lists the pages on it, in the order they are printed.
+// Pages are numbered from 1 for the first page of the book.
+void WriteHashes(const vector<uint64_t> &hashes, const vector<size_t> &order, size_t perSheet, const string &path)
+{
+	ofstream out(path);
+	out << hex << setfill('0');
+	for(size_t i = 0; i < hashes.size(); ++i)
+		out << "page " << dec << i + 1 << ' ' << hex << setw(16) << hashes[i] << '\n';
 	
-	// Render each page.
-	for(const Page &page : (reordered.empty() ? pages : reordered))
+	for(size_t first = 0; first < order.size(); first += perSheet)
 	{
-		for(const Fragment &fragment : page)
-			fragment.Draw(context, x * width, y * height);
-		for(const Leader &leader : page.Leaders())
-			leader.Draw(context, x * width, y * height);
-		
-		// Handle multiple pages being printed on one sheet. Only start a new
-		// PDF page if all song pages have been drawn on this one.
-		x = (x + 1) % xPages;
-		y = (y + 1) % yPages;
-		if(!x && !y)
-			context->show_page();
+		// The sheet's hash combines its pages' hashes and their positions.
+		uint64_t hash = 14695981039346656037ull;
+		size_t last = min(first + perSheet, order.size());
+		for(size_t i = first; i < last; ++i)
+		{
+			hash ^= hashes[order[i]] + i - first;
+			hash *= 1099511628211ull;
+		}
+		out << "sheet " << dec << first / perSheet + 1 << ' ' << hex << setw(16) << hash;
+		for(size_t i = first; i < last; ++i)
+			out << ' ' << dec << order[i] + 1;
+		out << '\n';
+	}
+}
+
+
+
+// Create a renderer for the given path, with the given number of pages side
+// by side on each sheet. If the path is empty, write a PDF to STDOUT.
+unique_ptr<Renderer> CreateRenderer(const string &path, int xPages)
+{
+	return Renderer::Create(path, Page::Width() * xPages, Page::Height());
+}
+
+
+
+// Add the bookmarks on the given page to the outline, and remember their
+// destinations so that links can point to them. If two bookmarks have the same
+// destination, only the first one is listed.
+void AddOutline(const Page &page, Renderer &renderer, set<string> &destinations)
+{
+	const vector<Page::Bookmark> &bookmarks = page.Bookmarks();
+	for(size_t i = 0; i < bookmarks.size(); ++i)
+	{
+		string destination = page.Destination(i);
+		if(destinations.insert(destination).second)
+			renderer.AddOutline(bookmarks[i].title, bookmarks[i].level, destination);
 	}
 }
 
 
 
-// Function to write output to STDOUT instead of to a named file.
-Cairo::ErrorStatus Write(const unsigned char *data, unsigned int length)
+// Draw a page in the given slot on the current sheet, and start a new sheet
+// if that was the last slot. A link to a page that is not in this output (for
+// example, in another volume) is left out.
+void DrawPage(const Page &page, Renderer &renderer, int slot, int xPages, const set<string> &destinations)
+{
+	double x = slot * Page::Width();
+	for(const Fragment &fragment : page)
+		fragment.Draw(renderer, x, 0.);
+	for(const Leader &leader : page.Leaders())
+		leader.Draw(renderer, x, 0.);
+	const vector<Page::Bookmark> &bookmarks = page.Bookmarks();
+	for(size_t i = 0; i < bookmarks.size(); ++i)
+		renderer.AddDestination(page.Destination(i), x, bookmarks[i].y);
+	for(const Page::Link &link : page.Links())
+		if(destinations.count(link.destination))
+			renderer.AddLink(x + link.x, link.y, link.width, link.height, link.destination);
+	
+	// Only start a new sheet once all its slots have been drawn on.
+	if(slot + 1 == xPages)
+		renderer.EndSheet();
+}
+
+
+
+// Check if two configurations produce the same pages, so they differ at most
+// in how those pages are arranged on the output sheets.
+bool SameLayout(const Config &a, const Config &b)
 {
-	cout.write(reinterpret_cast<const char *>(data), length);
-	return CAIRO_STATUS_SUCCESS;
+	// Booklets have page numbers on alternating sides, so they can only share
+	// a layout with other booklets, and slides are laid out differently from
+	// any book. Only "2up" is just a different arrangement of single pages.
+	Config first = a;
+	Config second = b;
+	first.Set("layout", a.Text("layout") == "2up" ? "single" : a.Text("layout", "single"));
+	second.Set("layout", b.Text("layout") == "2up" ? "single" : b.Text("layout", "single"));
+	return first == second;
 }
 
 
@@ -342,3 +1199,23 @@ bool EndsWith(const string &str, const string &end)
 	
 	return !str.compare(str.length() - end.length(), end.length(), end);
 }
+
+
+
+// Get the given path without its extension.
+string Stem(const string &path)
+{
+	return path.substr(0, path.rfind('.'));
+}
+
+
+
+// Apply a "key=value" setting to the given configuration.
+void SetValue(Config &config, const string &setting)
+{
+	size_t equals = setting.find('=');
+	if(equals == string::npos || !equals)
+		cerr << "Ignoring \"--set " << setting << "\": a setting must be of the form key=value." << endl;
+	else
+		config.Set(setting.substr(0, equals), setting.substr(equals + 1));
+}